@@ -4,11 +4,50 @@
 // shows course details with prerequisites.
 //
 // Build (examples):
-//   g++ -std=c++17 -O2 -Wall -Wextra -pedantic ProjectTwo.cpp -o advising
-//   clang++ -std=c++17 -O2 -Wall -Wextra -pedantic ProjectTwo.cpp -o advising
+//   g++ -std=c++17 -O2 -Wall -Wextra -pedantic -pthread ProjectTwo.cpp -o advising
+//   clang++ -std=c++17 -O2 -Wall -Wextra -pedantic -pthread ProjectTwo.cpp -o advising
 //
 // Run:
 //   ./advising
+//   ./advising --snapshot catalog.snap [courses.csv]
+//   ./advising --batch courses.csv < queries.txt
+//   ./advising --serve 8080 [--threads 4] courses.csv
+//   ./advising --store flat courses.csv
+//   ./advising --paged catalog.pages courses.csv < queries.txt
+//   ./advising --term fall2024=fall.csv --term spring2025=spring.csv
+//   ./advising-bench --bench [1000,100000]   (built with -DADVISING_BENCH)
+//
+// At a terminal, menu option 1 loads in the background: the menu shows the
+// load's progress each time it is printed, option 15 cancels it, and queries
+// answer from the current catalog until the new one is ready.
+//
+// Option 16 (or `dependents` in batch mode) lists the courses that need a
+// course, directly and through other courses, from a reverse prereq index.
+//
+// With --snapshot, startup maps a binary snapshot (saved via menu option 4)
+// instead of parsing CSV. If the snapshot is missing or older than its source
+// CSV, the CSV is loaded instead and the snapshot is rewritten.
+//
+// With --batch, no menu is shown: each line of stdin (or --queries FILE) is a
+// course number or command, and answers are written to stdout (see runBatch).
+// Adding --json switches answers to JSON (one course) and NDJSON (the list).
+//
+// With --serve (Linux), the catalog is served over HTTP instead of the menu;
+// see the HTTP query server section for the endpoints.
+//
+// --store picks how a loaded catalog is held: "avl" (the default, a balanced
+// tree) or "flat" (sorted arrays searched in Eytzinger order).
+//
+// Each --term NAME=FILE loads a named term catalog instead of one courses.csv;
+// the last one is current. Terms share their titles and prereq lists, and can
+// be switched between and compared (menu options 12-14, or `term` and `diff`
+// in batch mode).
+//
+// With --paged, the catalog stays on disk in a B+-tree file that is built from
+// the CSV with bounded memory when missing or stale, and batch queries are
+// answered through a small page cache (--pool-pages, 8 KiB pages). Only course
+// details, lookup, the list, prefix and range queries are available in this
+// mode, in text or (with --json) JSON.
 //
 // The input file should be CSV with lines like:
 //   CSCI100,Introduction to Computer Science
@@ -21,320 +60,6747 @@
 // - Prereq titles are resolved if present in the file; otherwise they’re flagged as missing.
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <random>
+#include <shared_mutex>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define ADVISING_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#define ADVISING_HAVE_EPOLL 1
+#include <cerrno>
+#include <csignal>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#endif
+
+// ---------- Vectorized text kernels ----------
+//
+// The loader's remaining per-byte work is finding the next ',' or '\n' and
+// uppercasing ASCII course numbers. Each kernel has a portable scalar form and
+// a vector form that handles 16 (SSE2, NEON) or 32 (AVX2) bytes per step; the
+// best one the CPU supports is picked once, on first use. Only the letters a-z
+// are changed, exactly as std::toupper does in the default "C" locale, so UTF-8
+// and every other byte >= 0x80 passes through untouched.
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ADVISING_HAVE_SSE2 1
+#define ADVISING_HAVE_AVX2 1 // compiled per function, used only if the CPU has it
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define ADVISING_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+struct TextKernels {
+    const char* name;
+    size_t (*findDelimiter)(const char* p, size_t n);          // first ',' or '\n', or n
+    size_t (*findLower)(const char* p, size_t n);              // first 'a'-'z', or n
+    void (*upperAscii)(const char* src, char* dst, size_t n);  // copy with a-z uppercased
+};
+
+static size_t findDelimiterScalar(const char* p, size_t n) {
+    size_t i = 0;
+    while (i < n && p[i] != ',' && p[i] != '\n') ++i;
+    return i;
+}
+
+static size_t findLowerScalar(const char* p, size_t n) {
+    size_t i = 0;
+    while (i < n && static_cast<unsigned char>(p[i] - 'a') > 'z' - 'a') ++i;
+    return i;
+}
+
+static void upperAsciiScalar(const char* src, char* dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        const char ch = src[i];
+        dst[i] = static_cast<unsigned char>(ch - 'a') <= 'z' - 'a' ? static_cast<char>(ch - 0x20) : ch;
+    }
+}
+
+#ifdef ADVISING_HAVE_SSE2
+// Bytes in a-z: subtracting 'a' maps exactly that range onto 0..25, and an
+// unsigned "min(x, 25) == x" test picks it out.
+static inline __m128i lowerMask128(__m128i v) {
+    const __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8('a'));
+    return _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(25)), shifted);
+}
+
+static size_t findDelimiterSse2(const char* p, size_t n) {
+    const __m128i comma = _mm_set1_epi8(','), newline = _mm_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        const int hits = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, newline)));
+        if (hits) return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(hits)));
+    }
+    return i + findDelimiterScalar(p + i, n - i);
+}
+
+static size_t findLowerSse2(const char* p, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const int hits = _mm_movemask_epi8(lowerMask128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i))));
+        if (hits) return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(hits)));
+    }
+    return i + findLowerScalar(p + i, n - i);
+}
+
+static void upperAsciiSse2(const char* src, char* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i flip = _mm_and_si128(lowerMask128(v), _mm_set1_epi8(0x20));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(v, flip));
+    }
+    upperAsciiScalar(src + i, dst + i, n - i);
+}
+#endif
+
+#ifdef ADVISING_HAVE_AVX2
+// The tails run the SSE2 kernels, which are not VEX-encoded: clear the upper
+// halves of the ymm registers first, or every legacy SSE instruction that
+// follows pays a state-transition penalty.
+__attribute__((target("avx2"))) static inline __m256i lowerMask256(__m256i v) {
+    const __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8('a'));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(25)), shifted);
+}
+
+__attribute__((target("avx2"))) static size_t findDelimiterAvx2(const char* p, size_t n) {
+    const __m256i comma = _mm256_set1_epi8(','), newline = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        const unsigned hits = static_cast<unsigned>(
+            _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, comma), _mm256_cmpeq_epi8(v, newline))));
+        if (hits) return i + static_cast<size_t>(__builtin_ctz(hits));
+    }
+    _mm256_zeroupper();
+    return i + findDelimiterSse2(p + i, n - i);
+}
+
+__attribute__((target("avx2"))) static size_t findLowerAvx2(const char* p, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const unsigned hits = static_cast<unsigned>(
+            _mm256_movemask_epi8(lowerMask256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)))));
+        if (hits) return i + static_cast<size_t>(__builtin_ctz(hits));
+    }
+    _mm256_zeroupper();
+    return i + findLowerSse2(p + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void upperAsciiAvx2(const char* src, char* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const __m256i flip = _mm256_and_si256(lowerMask256(v), _mm256_set1_epi8(0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(v, flip));
+    }
+    _mm256_zeroupper();
+    upperAsciiSse2(src + i, dst + i, n - i);
+}
+#endif
+
+#ifdef ADVISING_HAVE_NEON
+// Index of the first set byte in a 0x00/0xFF mask, or 16: narrowing shifts pack
+// each byte of the mask into 4 bits of one 64-bit lane.
+static inline size_t firstSetNeon(uint8x16_t mask) {
+    const uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(mask), 4)), 0);
+    return bits ? static_cast<size_t>(__builtin_ctzll(bits)) >> 2 : 16;
+}
+
+static inline uint8x16_t lowerMaskNeon(uint8x16_t v) {
+    return vcleq_u8(vsubq_u8(v, vdupq_n_u8('a')), vdupq_n_u8(25));
+}
+
+static size_t findDelimiterNeon(const char* p, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p + i));
+        const size_t hit = firstSetNeon(vorrq_u8(vceqq_u8(v, vdupq_n_u8(',')), vceqq_u8(v, vdupq_n_u8('\n'))));
+        if (hit < 16) return i + hit;
+    }
+    return i + findDelimiterScalar(p + i, n - i);
+}
+
+static size_t findLowerNeon(const char* p, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const size_t hit = firstSetNeon(lowerMaskNeon(vld1q_u8(reinterpret_cast<const uint8_t*>(p + i))));
+        if (hit < 16) return i + hit;
+    }
+    return i + findLowerScalar(p + i, n - i);
+}
+
+static void upperAsciiNeon(const char* src, char* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        const uint8x16_t flip = vandq_u8(lowerMaskNeon(v), vdupq_n_u8(0x20));
+        vst1q_u8(reinterpret_cast<uint8_t*>(dst + i), veorq_u8(v, flip));
+    }
+    upperAsciiScalar(src + i, dst + i, n - i);
+}
+#endif
+
+// ADVISING_SCALAR_TEXT=1 in the environment forces the portable kernels, for
+// comparing results and timings.
+static const TextKernels& textKernels() {
+    static const TextKernels kernels = [] {
+        const char* forced = std::getenv("ADVISING_SCALAR_TEXT");
+        if (forced && *forced && *forced != '0') {
+            return TextKernels{"scalar", findDelimiterScalar, findLowerScalar, upperAsciiScalar};
+        }
+#if defined(ADVISING_HAVE_AVX2)
+        if (__builtin_cpu_supports("avx2")) {
+            return TextKernels{"avx2", findDelimiterAvx2, findLowerAvx2, upperAsciiAvx2};
+        }
+#endif
+#if defined(ADVISING_HAVE_SSE2)
+        return TextKernels{"sse2", findDelimiterSse2, findLowerSse2, upperAsciiSse2};
+#elif defined(ADVISING_HAVE_NEON)
+        return TextKernels{"neon", findDelimiterNeon, findLowerNeon, upperAsciiNeon};
+#else
+        return TextKernels{"scalar", findDelimiterScalar, findLowerScalar, upperAsciiScalar};
+#endif
+    }();
+    return kernels;
+}
+
 // ---------- Small string helpers ----------
 
-static inline std::string trimCopy(const std::string& s) {
+// The "C" locale's isspace(), without the locale lookup.
+static inline bool isAsciiSpace(char ch) { return ch == ' ' || (ch >= '\t' && ch <= '\r'); }
+
+static inline std::string_view trimView(std::string_view s) {
     size_t b = 0, e = s.size();
-    while (b < e && std::isspace(static_cast<unsigned char>(s[b]))) ++b;
-    while (e > b && std::isspace(static_cast<unsigned char>(s[e - 1]))) --e;
+    while (b < e && isAsciiSpace(s[b])) ++b;
+    while (e > b && isAsciiSpace(s[e - 1])) --e;
     return s.substr(b, e - b);
 }
 
-static inline void toUpperInPlace(std::string& s) {
-    for (char& ch : s) ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+static inline std::string trimCopy(const std::string& s) { return std::string(trimView(s)); }
+
+static inline void toUpperInPlace(std::string& s) { textKernels().upperAscii(s.data(), &s[0], s.size()); }
+
+// Normalizes the bounds of a course range query. An empty `hi` means "every
+// number starting with lo"; otherwise the bounds are put in order. Returns
+// false when `lo` is empty.
+static bool normalizeRange(const std::string& rawLo, const std::string& rawHi, std::string& lo, std::string& hi) {
+    lo = trimCopy(rawLo);
+    hi = trimCopy(rawHi);
+    toUpperInPlace(lo);
+    toUpperInPlace(hi);
+    if (lo.empty()) return false;
+    if (!hi.empty() && hi < lo) std::swap(lo, hi);
+    return true;
 }
 
-static std::vector<std::string> splitCSV(const std::string& line) {
-    // Simple CSV split by commas (titles do not contain commas per assignment).
-    std::vector<std::string> parts;
-    std::string cur;
-    std::istringstream iss(line);
-    while (std::getline(iss, cur, ',')) {
-        parts.push_back(trimCopy(cur));
+// Appends `s` as a JSON string literal. Bytes >= 0x80 pass through untouched,
+// so UTF-8 titles stay UTF-8.
+static void appendJsonString(std::string& out, std::string_view s) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    out.push_back('"');
+    for (char ch : s) {
+        unsigned char u = static_cast<unsigned char>(ch);
+        switch (ch) {
+        case '"': out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\n': out.append("\\n"); break;
+        case '\r': out.append("\\r"); break;
+        case '\t': out.append("\\t"); break;
+        default:
+            if (u < 0x20) {
+                out.append("\\u00");
+                out.push_back(kHex[u >> 4]);
+                out.push_back(kHex[u & 0xF]);
+            } else {
+                out.push_back(ch);
+            }
+        }
     }
-    return parts;
+    out.push_back('"');
 }
 
-// ---------- Core domain model ----------
+// ---------- Read-only file mapping ----------
+//
+// Maps a whole file into memory so the loader can tokenize it in place. Where
+// mmap is unavailable the file is read into an owned buffer instead.
 
-struct Course {
-    std::string number;               // e.g., "CSCI200"
-    std::string title;                // e.g., "Data Structures"
-    std::vector<std::string> prereqs; // e.g., {"CSCI100", "MATH201"}
+// Size and modification time, used to tell whether a snapshot is still current.
+struct FileStamp {
+    uint64_t size{0};
+    int64_t mtimeNs{0};
+
+    bool operator==(const FileStamp& o) const { return size == o.size && mtimeNs == o.mtimeNs; }
+    bool operator!=(const FileStamp& o) const { return !(*this == o); }
 };
 
-// ---------- Binary Search Tree keyed by course number ----------
+#ifdef ADVISING_HAVE_MMAP
+static FileStamp stampOf(const struct stat& st) {
+    FileStamp fs;
+    fs.size = static_cast<uint64_t>(st.st_size);
+#ifdef __APPLE__
+    fs.mtimeNs = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    fs.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return fs;
+}
+#endif
 
-struct Node {
-    Course course;
-    Node* left{nullptr};
-    Node* right{nullptr};
-    explicit Node(const Course& c) : course(c) {}
+static bool statFile(const std::string& path, FileStamp& out) {
+#ifdef ADVISING_HAVE_MMAP
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) return false;
+    out = stampOf(st);
+    return true;
+#else
+    // Without stat() only the size is comparable.
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) return false;
+    out = FileStamp{static_cast<uint64_t>(in.tellg()), 0};
+    return true;
+#endif
+}
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+#ifdef ADVISING_HAVE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        stamp_ = stampOf(st);
+        size_t size = static_cast<size_t>(st.st_size);
+        if (size > 0) {
+            void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                return false;
+            }
+            ::madvise(p, size, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(p);
+            size_ = size;
+        }
+        ::close(fd);
+        return true;
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) return false;
+        owned_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = owned_.data();
+        size_ = owned_.size();
+        stamp_ = FileStamp{size_, 0};
+        return true;
+#endif
+    }
+
+    void close() {
+#ifdef ADVISING_HAVE_MMAP
+        if (data_) ::munmap(const_cast<char*>(data_), size_);
+#else
+        owned_.clear();
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    std::string_view data() const { return {data_, size_}; }
+    const FileStamp& stamp() const { return stamp_; }
+
+private:
+    const char* data_{nullptr};
+    size_t size_{0};
+    FileStamp stamp_;
+#ifndef ADVISING_HAVE_MMAP
+    std::string owned_;
+#endif
 };
 
-class CourseBST {
+// ---------- Catalog arena ----------
+//
+// Bump allocator that backs every node, string and table of the catalogs in a
+// pool (see CatalogPool). Objects are packed into large blocks and never freed
+// individually; release() hands all blocks back at once, so dropping a pool
+// costs one pass over the block list instead of one delete per node and string.
+
+class Arena {
 public:
-    CourseBST() = default;
-    ~CourseBST() { clear(root_); }
+    Arena() = default;
+    ~Arena() { release(); }
 
-    void clearAll() {
-        clear(root_);
-        root_ = nullptr;
-        count_ = 0;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t align) {
+        size_t pad = (align - reinterpret_cast<uintptr_t>(cur_) % align) % align;
+        if (static_cast<size_t>(end_ - cur_) < pad + bytes) {
+            grow(bytes + align);
+            pad = (align - reinterpret_cast<uintptr_t>(cur_) % align) % align;
+        }
+        char* p = cur_ + pad;
+        cur_ = p + bytes;
+        return p;
     }
 
-    size_t size() const { return count_; }
+    // Only trivially destructible types may live here: release() runs no destructors.
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
 
-    // Insert or replace: if the key already exists, title/prereqs are updated.
-    void insertOrAssign(const Course& c) {
-        insertOrAssignImpl(root_, c);
+    template <typename T>
+    T* copyArray(const T* src, size_t n) {
+        static_assert(std::is_trivially_copyable<T>::value, "arena arrays are copied bytewise");
+        if (n == 0) return nullptr;
+        T* dst = static_cast<T*>(allocate(sizeof(T) * n, alignof(T)));
+        std::memcpy(dst, src, sizeof(T) * n);
+        return dst;
     }
 
-    const Course* find(const std::string& number) const {
-        Node* cur = root_;
-        while (cur) {
-            if (number == cur->course.number) return &cur->course;
-            if (number < cur->course.number) cur = cur->left;
-            else cur = cur->right;
+    std::string_view copy(std::string_view s) {
+        if (s.empty()) return {};
+        char* dst = static_cast<char*>(allocate(s.size(), 1));
+        std::memcpy(dst, s.data(), s.size());
+        return {dst, s.size()};
+    }
+
+    void release() {
+        while (head_) {
+            Block* next = head_->next;
+            ::operator delete(head_);
+            head_ = next;
         }
-        return nullptr;
+        cur_ = end_ = nullptr;
+        reserved_ = 0;
     }
 
-    // In-order traversal: lowest -> highest
-    template <typename Fn>
-    void inOrder(Fn&& fn) const {
-        inOrderImpl(root_, fn);
+    // Bytes obtained from the heap for blocks, used or not.
+    size_t bytesReserved() const { return reserved_; }
+
+private:
+    struct alignas(std::max_align_t) Block {
+        Block* next;
+    };
+
+    static constexpr size_t kBlockSize = 64 * 1024;
+
+    Block* head_{nullptr};
+    char* cur_{nullptr};
+    char* end_{nullptr};
+    size_t reserved_{0};
+
+    void grow(size_t atLeast) {
+        size_t size = std::max(kBlockSize, sizeof(Block) + atLeast);
+        Block* b = static_cast<Block*>(::operator new(size));
+        reserved_ += size;
+        b->next = head_;
+        head_ = b;
+        cur_ = reinterpret_cast<char*>(b + 1);
+        end_ = reinterpret_cast<char*>(b) + size;
     }
+};
+
+// Read-only view over a contiguous array (C++17 has no std::span).
+template <typename T>
+class Span {
+public:
+    Span() = default;
+    Span(const T* data, size_t size) : data_(data), size_(size) {}
+
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const T& operator[](size_t i) const { return data_[i]; }
 
 private:
-    Node* root_{nullptr};
-    size_t count_{0};
+    const T* data_{nullptr};
+    size_t size_{0};
+};
 
-    static void clear(Node* n) {
-        if (!n) return;
-        clear(n->left);
-        clear(n->right);
-        delete n;
+// Number of bits needed to write k, i.e. floor(log2(k)) + 1 (0 for 0).
+static int bitWidth(size_t k) {
+    int w = 0;
+    while (k) {
+        ++w;
+        k >>= 1;
     }
+    return w;
+}
 
-    void insertOrAssignImpl(Node*& n, const Course& c) {
-        if (!n) {
-            n = new Node(c);
-            ++count_;
-            return;
-        }
-        if (c.number < n->course.number) {
-            insertOrAssignImpl(n->left, c);
-        } else if (c.number > n->course.number) {
-            insertOrAssignImpl(n->right, c);
-        } else {
-            // Replace/assign existing node's payload (keeps tree shape stable).
-            n->course.title = c.title;
-            n->course.prereqs = c.prereqs;
+// floor(log2(k)) for k > 0, without bitWidth's loop where the compiler has one.
+static int floorLog2(size_t k) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(static_cast<unsigned long long>(k));
+#else
+    return bitWidth(k) - 1;
+#endif
+}
+
+// Copy-on-write table indexed by id, in fixed chunks taken from an arena. A
+// table started from another one shares every chunk and copies a chunk only
+// when it first writes to it, so a catalog built as an edit of another pays
+// for the chunks its edits touch, not for a table the size of the catalog.
+// Shared chunks are never written, which keeps the base table safe to read
+// concurrently.
+template <typename T>
+class CowTable {
+    static_assert(std::is_trivially_copyable<T>::value, "chunks are copied bytewise");
+
+public:
+    size_t size() const { return size_; }
+    const T& operator[](size_t i) const { return chunks_[i >> kShift][i & kMask]; }
+
+    // Starts as `base`, sharing all of its chunks. Base's arena must outlive
+    // the table, and base must not be written afterwards.
+    void shareFrom(const CowTable& base) {
+        chunks_ = base.chunks_;
+        owned_.assign(chunks_.size(), false);
+        size_ = base.size_;
+    }
+
+    // Grows to at least `n` entries; new ones are value-initialized.
+    void resize(size_t n, Arena& arena) {
+        while (chunks_.size() * kChunk < n) {
+            T* chunk = static_cast<T*>(arena.allocate(sizeof(T) * kChunk, alignof(T)));
+            std::uninitialized_fill_n(chunk, kChunk, T{});
+            chunks_.push_back(chunk);
+            owned_.push_back(true);
         }
+        size_ = std::max(size_, n);
     }
 
-    template <typename Fn>
-    static void inOrderImpl(Node* n, Fn&& fn) {
-        if (!n) return;
-        inOrderImpl(n->left, fn);
-        fn(n->course);
-        inOrderImpl(n->right, fn);
+    // Entry i for writing, copying its chunk first if it is shared.
+    T& mutableAt(size_t i, Arena& arena) {
+        const size_t c = i >> kShift;
+        if (!owned_[c]) {
+            chunks_[c] = arena.copyArray(chunks_[c], kChunk);
+            owned_[c] = true;
+        }
+        return chunks_[c][i & kMask];
     }
+
+    // Heap bytes outside the arena (the chunk directory).
+    size_t heapBytes() const { return chunks_.capacity() * sizeof(T*) + owned_.capacity() / 8; }
+
+private:
+    static constexpr size_t kShift = 8;
+    static constexpr size_t kChunk = size_t{1} << kShift;
+    static constexpr size_t kMask = kChunk - 1;
+
+    std::vector<T*> chunks_;
+    std::vector<bool> owned_;
+    size_t size_{0};
 };
 
-// ---------- Planner orchestrates loading, storage, and printing ----------
+// ---------- Packed course keys ----------
+//
+// Course numbers are short tokens like "CSCI200", so nearly all of them fit in
+// two machine words. A CourseKey holds the first 15 bytes big-endian and
+// zero-padded, with the length in the final byte: comparing keys as integers
+// orders them exactly like the strings, and comparing or hashing one reads no
+// string memory. Longer numbers get kLong as their length byte and keep the
+// 15-byte prefix for ordering. Two long keys that are equal only say the
+// prefixes match, so callers break such ties by course id when both sides are
+// interned in one table, and by comparing the strings otherwise.
 
-class CoursePlanner {
-public:
-    bool loadFromFile(const std::string& filename, std::string& outError) {
-        std::ifstream in(filename);
-        if (!in.is_open()) {
-            outError = "Error: Could not open file \"" + filename + "\".";
-            return false;
+struct CourseKey {
+    static constexpr size_t kMaxPacked = 15;
+    static constexpr uint64_t kLong = 0xFF;
+
+    uint64_t hi{0};
+    uint64_t lo{0};
+
+    static constexpr CourseKey from(std::string_view s) {
+        CourseKey k;
+        const size_t n = s.size() < kMaxPacked ? s.size() : kMaxPacked;
+        for (size_t i = 0; i < n; ++i) {
+            const uint64_t byte = static_cast<unsigned char>(s[i]);
+            if (i < 8) {
+                k.hi |= byte << (56 - 8 * i);
+            } else {
+                k.lo |= byte << (56 - 8 * (i - 8));
+            }
         }
+        k.lo |= s.size() <= kMaxPacked ? s.size() : kLong;
+        return k;
+    }
 
-        // Reset any previously loaded data
-        tree_.clearAll();
-        index_.clear();
+    // True when the key holds the whole number, so equal keys mean equal numbers.
+    constexpr bool packed() const { return (lo & 0xFF) != kLong; }
 
-        std::string line;
-        size_t lineNum = 0;
-        size_t loaded = 0;
-        size_t skipped = 0;
+    constexpr bool operator<(const CourseKey& o) const { return hi < o.hi || (hi == o.hi && lo < o.lo); }
+    constexpr bool operator==(const CourseKey& o) const { return hi == o.hi && lo == o.lo; }
+    constexpr bool operator!=(const CourseKey& o) const { return !(*this == o); }
 
-        while (std::getline(in, line)) {
-            ++lineNum;
-            std::string trimmed = trimCopy(line);
-            if (trimmed.empty()) continue; // allow blank lines
+    size_t hash() const {
+        uint64_t h = (hi * 0x9E3779B97F4A7C15ull) ^ lo;
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ull;
+        h ^= h >> 32;
+        return static_cast<size_t>(h);
+    }
+};
 
-            auto parts = splitCSV(trimmed);
-            if (parts.size() < 2) {
-                std::cerr << "Warning (line " << lineNum
-                          << "): expected at least course number and title. Skipping line.\n";
-                ++skipped;
-                continue;
-            }
+struct CourseKeyHash {
+    size_t operator()(const CourseKey& k) const { return k.hash(); }
+};
 
-            // Normalize course number to uppercase for consistent keys
-            std::string courseNum = parts[0];
-            toUpperInPlace(courseNum);
+static_assert(CourseKey::from("CSCI200") < CourseKey::from("CSCI300"), "keys order like their numbers");
+static_assert(CourseKey::from("CSCI") < CourseKey::from("CSCI100"), "a prefix sorts first");
+static_assert(CourseKey::from("ABCDEFGHIJKLMNO") < CourseKey::from("ABCDEFGHIJKLMNOP"), "long keys sort last");
+static_assert(!CourseKey::from("ABCDEFGHIJKLMNOP").packed(), "16 bytes do not pack");
 
-            Course c;
-            c.number = courseNum;
-            c.title = parts[1];
+// Course-number order and equality through the packed keys; the strings are
+// read only for two long numbers that share their packed prefix.
+static constexpr bool numberLess(const CourseKey& ka, std::string_view a, const CourseKey& kb, std::string_view b) {
+    if (ka != kb) return ka < kb;
+    return !ka.packed() && a < b;
+}
 
-            // Remaining parts (if any) are prerequisites
-            for (size_t i = 2; i < parts.size(); ++i) {
-                std::string p = parts[i];
-                toUpperInPlace(p);
-                if (!p.empty()) c.prereqs.push_back(p);
-            }
+static constexpr bool numberEqual(const CourseKey& ka, std::string_view a, const CourseKey& kb, std::string_view b) {
+    return ka == kb && (ka.packed() || a == b);
+}
 
-            tree_.insertOrAssign(c);
-            index_[c.number] = c.title; // keep an index for quick title lookup
-            ++loaded;
-        }
+static_assert(CourseKey::from("ABCDEFGHIJKLMNOP1") == CourseKey::from("ABCDEFGHIJKLMNOP2"), "long keys tie");
+static_assert(numberLess(CourseKey::from("ABCDEFGHIJKLMNOP1"), "ABCDEFGHIJKLMNOP1",
+                         CourseKey::from("ABCDEFGHIJKLMNOP2"), "ABCDEFGHIJKLMNOP2"),
+              "the strings break a long tie");
+static_assert(!numberEqual(CourseKey::from("ABCDEFGHIJKLMNOP1"), "ABCDEFGHIJKLMNOP1",
+                           CourseKey::from("ABCDEFGHIJKLMNOP2"), "ABCDEFGHIJKLMNOP2"),
+              "long numbers with one prefix stay distinct");
+static_assert(numberLess(CourseKey::from("ABCDEFGHIJKLMNOZ"), "ABCDEFGHIJKLMNOZ",
+                         CourseKey::from("ABCDEFGHIJKLMNPA"), "ABCDEFGHIJKLMNPA"),
+              "long numbers that differ early order by key alone");
 
-        if (loaded == 0) {
-            outError = "Error: No valid course records were loaded from the file.";
-            return false;
-        }
+// ---------- Core domain model ----------
+
+// Dense identifier for an interned, normalized course number.
+using CourseId = uint32_t;
+constexpr CourseId kNoCourse = UINT32_MAX;
+
+// Strings are views: a stored Course points into the catalog arena that owns it.
+struct Course {
+    CourseId id{kNoCourse};
+    CourseKey key;                    // `number` packed, for comparisons
+    std::string_view number;          // e.g., "CSCI200" (owned by the symbol table)
+    std::string_view title;           // e.g., "Data Structures"
+    Span<CourseId> prereqs;           // e.g., ids of {"CSCI100", "MATH201"}
+};
 
-        loaded_ = true;
-        lastFilename_ = filename;
+static bool numberLess(const Course& a, const Course& b) { return numberLess(a.key, a.number, b.key, b.number); }
 
-        std::cout << "Loaded " << loaded << " course(s)";
-        if (skipped) std::cout << " (" << skipped << " line(s) skipped for format issues)";
-        std::cout << ".\n";
+// numberLess for two courses interned in the same symbol table, where equal
+// ids mean equal numbers: a long-key tie between rows of one course is settled
+// by id without reading either string.
+static bool internedLess(const Course& a, const Course& b) {
+    if (a.key != b.key) return a.key < b.key;
+    return !a.key.packed() && a.id != b.id && a.number < b.number;
+}
 
-        return true;
+// One course a catalog built as an edit of another adds (before is null),
+// removes (after is null) or replaces. Both records have the same id.
+struct CourseEdit {
+    const Course* before;
+    const Course* after;
+};
+
+// ---------- Course number symbol table ----------
+//
+// Each normalized course number is stored once and mapped to a dense id.
+// Prereqs that name a course missing from the file still get an id, so every
+// edge resolves by array index; callers track which ids are actually defined.
+// A table is shared by every catalog in a pool (see CatalogPool) and keeps
+// growing while catalogs built from it are being read: names sit in chunks
+// that never move, so name() takes no lock, and the reverse map is guarded by
+// a reader-writer lock that only inserts take exclusively.
+
+class CourseSymbols {
+public:
+    explicit CourseSymbols(Arena& arena) : arena_(arena) {}
+
+    CourseSymbols(const CourseSymbols&) = delete;
+    CourseSymbols& operator=(const CourseSymbols&) = delete;
+
+    CourseId intern(std::string_view number) { return intern(number, CourseKey::from(number)); }
+
+    // `key` must be CourseKey::from(number). Only one thread (the loader)
+    // interns at a time.
+    CourseId intern(std::string_view number, const CourseKey& key) {
+        ensureIndexed();
+        if (CourseId id = lookup(number, key); id != kNoCourse) return id;
+        CourseId id = static_cast<CourseId>(size_);
+        std::string_view stored = arena_.copy(number);
+        push(stored);
+        std::unique_lock<std::shared_mutex> lock(mapMutex_);
+        index(stored, key, id);
+        return id;
     }
 
-    bool isLoaded() const { return loaded_; }
+    CourseId find(std::string_view number) const {
+        ensureIndexed();
+        std::shared_lock<std::shared_mutex> lock(mapMutex_);
+        return lookup(number, CourseKey::from(number));
+    }
 
-    void printCourseList() const {
-        if (!loaded_) {
-            std::cout << "Please load data first (Option 1).\n";
-            return;
-        }
-        std::cout << "\nABCU Computer Science Course List (sorted)\n";
-        std::cout << "-----------------------------------------\n";
-        size_t count = 0;
-        tree_.inOrder([&](const Course& c) {
-            std::cout << c.number << ", " << c.title << "\n";
-            ++count;
-        });
-        std::cout << "-----------------------------------------\n";
-        std::cout << "Total: " << count << " course(s)\n\n";
+    // Safe from any thread for an id the caller got from a published catalog.
+    std::string_view name(CourseId id) const {
+        const size_t v = size_t{id} + kFirstChunk;
+        const int c = floorLog2(v) - kFirstShift;
+        return chunks_[c][v - (size_t{1} << (c + kFirstShift))];
     }
 
-    void printCourseInfo(const std::string& rawNumber) const {
-        if (!loaded_) {
-            std::cout << "Please load data first (Option 1).\n";
-            return;
-        }
-        std::string number = trimCopy(rawNumber);
-        toUpperInPlace(number);
-        if (number.empty()) {
-            std::cout << "Error: course number cannot be empty.\n";
-            return;
-        }
+    // Ids handed out so far. Only meaningful to the loader; catalogs keep the
+    // count they were built with (SymbolView).
+    size_t size() const { return size_; }
 
-        const Course* c = tree_.find(number);
-        if (!c) {
-            std::cout << "Course \"" << number << "\" was not found. "
-                      << "Be sure you typed the correct course number (e.g., CSCI200).\n";
-            return;
+    // Fills an empty table with a complete id -> name table (e.g. from a
+    // snapshot) whose strings outlive these symbols. The reverse map is only
+    // built once find() or intern() needs it, and then exactly once.
+    void adopt(const std::vector<std::string_view>& names) {
+        for (std::string_view n : names) push(n);
+        deferred_ = true;
+    }
+
+private:
+    // Chunk c holds 2^(c + kFirstShift) names, so the chunks double in size
+    // and a few dozen of them cover every possible id.
+    static constexpr int kFirstShift = 10;
+    static constexpr size_t kFirstChunk = size_t{1} << kFirstShift;
+    static constexpr int kChunks = 64 - kFirstShift;
+
+    Arena& arena_;
+    std::string_view* chunks_[kChunks] = {};
+    size_t size_{0};
+    // Numbers that pack are found by key alone; the rare longer ones by string.
+    mutable std::unordered_map<CourseKey, CourseId, CourseKeyHash> packedIds_;
+    mutable std::unordered_map<std::string_view, CourseId> longIds_;
+    mutable std::shared_mutex mapMutex_;
+    bool deferred_{false};
+    mutable std::once_flag indexOnce_;
+
+    void push(std::string_view number) {
+        const size_t v = size_ + kFirstChunk;
+        const int c = floorLog2(v) - kFirstShift;
+        const size_t at = v - (size_t{1} << (c + kFirstShift));
+        if (at == 0) {
+            chunks_[c] = static_cast<std::string_view*>(
+                arena_.allocate(sizeof(std::string_view) << (c + kFirstShift), alignof(std::string_view)));
         }
+        new (chunks_[c] + at) std::string_view(number);
+        ++size_;
+    }
 
-        std::cout << "\n" << c->number << ": " << c->title << "\n";
+    CourseId lookup(std::string_view number, const CourseKey& key) const {
+        if (key.packed()) {
+            auto it = packedIds_.find(key);
+            return it == packedIds_.end() ? kNoCourse : it->second;
+        }
+        auto it = longIds_.find(number);
+        return it == longIds_.end() ? kNoCourse : it->second;
+    }
 
-        if (c->prereqs.empty()) {
-            std::cout << "Prerequisites: None\n\n";
-            return;
+    void index(std::string_view number, const CourseKey& key, CourseId id) const {
+        if (key.packed()) {
+            packedIds_.emplace(key, id);
+        } else {
+            longIds_.emplace(number, id);
         }
+    }
 
-        std::cout << "Prerequisites:\n";
-        for (const std::string& p : c->prereqs) {
-            auto it = index_.find(p);
-            if (it != index_.end()) {
-                std::cout << "  - " << p << ": " << it->second << "\n";
-            } else {
-                std::cout << "  - " << p << " (title not found in file)\n";
+    void ensureIndexed() const {
+        if (!deferred_) return;
+        std::call_once(indexOnce_, [this] {
+            packedIds_.reserve(size_);
+            for (size_t i = 0; i < size_; ++i) {
+                const CourseId id = static_cast<CourseId>(i);
+                index(name(id), CourseKey::from(name(id)), id);
             }
-        }
-        std::cout << "\n";
+        });
     }
+};
+
+// The ids one catalog knows: those its table had handed out when the catalog
+// was built. Catalogs built later from the same table may add more; a view
+// never shows them.
+class SymbolView {
+public:
+    SymbolView() = default;
+    SymbolView(const CourseSymbols& table, size_t count) : table_(&table), count_(count) {}
 
-    const std::string& lastFilename() const { return lastFilename_; }
+    std::string_view name(CourseId id) const { return table_->name(id); }
+    size_t size() const { return count_; }
+
+    CourseId find(std::string_view number) const {
+        const CourseId id = table_ ? table_->find(number) : kNoCourse;
+        return id < count_ ? id : kNoCourse;
+    }
 
 private:
-    CourseBST tree_;
-    std::unordered_map<std::string, std::string> index_; // courseNum -> title
-    bool loaded_{false};
-    std::string lastFilename_;
+    const CourseSymbols* table_{nullptr};
+    size_t count_{0};
 };
 
-// ---------- Menu / UI loop ----------
+// ---------- Catalog pool ----------
+//
+// Storage a lineage of catalogs shares: the arena their records, nodes and
+// tables come from, and the one symbol table that numbers their courses. A
+// catalog built as an edit of another (a reload that changed a few courses,
+// the next term) lives in the same pool, so an unchanged course keeps its id,
+// its record, its strings and its prereq list, and the new catalog just points
+// at them. Only loaders add to a pool, one at a time; stored bytes never move,
+// so readers of any catalog in it use them without locking. A pool only grows,
+// and goes away with the last catalog that uses it.
+//
+// Terms (see CoursePlanner::loadTerm) also intern titles and prereq lists
+// here, so text that repeats from term to term is stored once even when a term
+// has to be built in full: two terms hold the same title or prereq list
+// exactly when the views point to the same place.
 
-static void printMenu() {
-    std::cout << "================= ABCU Advising Assistance =================\n";
-    std::cout << "1. Load data structure from file\n";
-    std::cout << "2. Print an alphanumeric list of all courses\n";
-    std::cout << "3. Print course information (title and prerequisites)\n";
-    std::cout << "9. Exit\n";
-    std::cout << "=============================================================\n";
-    std::cout << "Enter your choice (1, 2, 3, or 9): ";
-}
+class CatalogPool {
+public:
+    Arena& arena() { return arena_; }
+    CourseSymbols& symbols() { return symbols_; }
+    const CourseSymbols& symbols() const { return symbols_; }
+    size_t bytesReserved() const { return arena_.bytesReserved(); }
 
-int main() {
-    std::ios::sync_with_stdio(false);
+    std::string_view intern(std::string_view s) {
+        if (s.empty()) return {};
+        auto it = strings_.find(s);
+        if (it != strings_.end()) return *it;
+        return *strings_.insert(arena_.copy(s)).first;
+    }
 
-    CoursePlanner planner;
+    Span<CourseId> intern(Span<CourseId> ids) {
+        if (ids.empty()) return {};
+        auto it = lists_.find(ids);
+        if (it != lists_.end()) return *it;
+        return *lists_.insert({arena_.copyArray(ids.begin(), ids.size()), ids.size()}).first;
+    }
 
-    while (true) {
-        printMenu();
+    std::unique_ptr<MappedFile> snapshot; // backing storage when first filled from a snapshot
+    size_t fullBuildBytes{0};             // what the latest full build here added to the arena
 
-        std::string choiceLine;
-        if (!std::getline(std::cin, choiceLine)) {
-            std::cout << "\nInput stream closed. Exiting.\n";
-            break;
+private:
+    struct ListBytes {
+        static std::string_view bytes(Span<CourseId> ids) {
+            return {reinterpret_cast<const char*>(ids.begin()), ids.size() * sizeof(CourseId)};
         }
-        std::string choice = trimCopy(choiceLine);
+        size_t operator()(Span<CourseId> ids) const { return std::hash<std::string_view>{}(bytes(ids)); }
+        bool operator()(Span<CourseId> a, Span<CourseId> b) const { return bytes(a) == bytes(b); }
+    };
 
-        if (choice == "1") {
-            std::cout << "Enter the course data filename (e.g., courses.csv): ";
-            std::string fname;
-            std::getline(std::cin, fname);
-            fname = trimCopy(fname);
+    Arena arena_; // declared first so it outlives its users
+    CourseSymbols symbols_{arena_};
+    std::unordered_set<std::string_view> strings_;
+    std::unordered_set<Span<CourseId>, ListBytes, ListBytes> lists_;
+};
 
-            if (fname.empty()) {
-                std::cout << "Error: filename cannot be empty.\n\n";
-                continue;
-            }
+// ---------- Course storage interface ----------
+//
+// A catalog keeps its courses in one ordered store picked at load time (see
+// StoreKind). Courses themselves are records owned by the catalog; a store
+// indexes them by number, so the courses it returns are the records it was
+// given. Stores are filled once from sorted records and then only read, so the
+// interface is a point lookup plus an ordered scan. A catalog built as an edit
+// of another asks the other's store for an edited copy instead.
 
-            std::string err;
-            if (!planner.loadFromFile(fname, err)) {
-                std::cout << err << "\n\n";
-            } else {
-                std::cout << "File \"" << planner.lastFilename() << "\" loaded successfully.\n\n";
-            }
+// Non-owning reference to a callable taking a course and returning whether the
+// walk should go on. Keeps scans virtual without allocating a std::function.
+class CourseVisitor {
+public:
+    template <typename Fn, typename = std::enable_if_t<!std::is_same<std::decay_t<Fn>, CourseVisitor>::value>>
+    CourseVisitor(Fn& fn)
+        : obj_(const_cast<void*>(static_cast<const void*>(&fn))),
+          call_([](void* obj, const Course& c) -> bool { return (*static_cast<Fn*>(obj))(c); }) {}
 
-        } else if (choice == "2") {
-            planner.printCourseList();
+    bool operator()(const Course& c) const { return call_(obj_, c); }
 
-        } else if (choice == "3") {
-            std::cout << "Enter a course number to look up (e.g., CSCI200): ";
+private:
+    void* obj_;
+    bool (*call_)(void*, const Course&);
+};
+
+class CourseStore {
+public:
+    virtual ~CourseStore() = default;
+
+    virtual const char* kind() const = 0;
+    virtual size_t size() const = 0;
+    // Levels a lookup may descend (tree height, or probes of a flat search).
+    virtual int height() const = 0;
+
+    // Replaces the contents. `sorted` must be strictly ascending by course
+    // number, and the records must outlive the store; they are not copied.
+    virtual void buildFromSorted(const std::vector<const Course*>& sorted) = 0;
+
+    // A new store holding `sorted`, which must be this store's contents with
+    // `edits` applied. This store is left as it is and may be read meanwhile.
+    // The copy may share what this store allocated, so this store's arena
+    // must outlive it.
+    virtual std::unique_ptr<CourseStore> edited(Arena& arena, const std::vector<const Course*>& sorted,
+                                                const std::vector<CourseEdit>& edits) const = 0;
+
+    // Heap bytes the store holds outside the arena it was given.
+    virtual size_t heapBytes() const = 0;
+
+    virtual const Course* find(std::string_view number) const = 0;
+
+    // find() for each of `numbers`, into out[0 .. numbers.size()). Stores that
+    // can overlap the searches' cache misses override this.
+    virtual void findMany(Span<std::string_view> numbers, const Course** out) const {
+        for (size_t i = 0; i < numbers.size(); ++i) out[i] = find(numbers[i]);
+    }
+
+    // Visits courses with number >= `from` in ascending order until `fn`
+    // returns false.
+    virtual void scanFrom(std::string_view from, CourseVisitor fn) const = 0;
+
+    // In-order traversal: lowest -> highest
+    template <typename Fn>
+    void inOrder(Fn&& fn) const {
+        auto each = [&](const Course& c) {
+            fn(c);
+            return true;
+        };
+        scanFrom({}, each);
+    }
+
+    // Visits lo <= number <= hi in order.
+    template <typename Fn>
+    void visitRange(std::string_view lo, std::string_view hi, Fn&& fn) const {
+        const CourseKey hiKey = CourseKey::from(hi);
+        auto each = [&](const Course& c) {
+            if (numberLess(hiKey, hi, c.key, c.number)) return false;
+            fn(c);
+            return true;
+        };
+        scanFrom(lo, each);
+    }
+
+    // Visits every course whose number starts with `prefix`, in order.
+    template <typename Fn>
+    void visitPrefix(std::string_view prefix, Fn&& fn) const {
+        auto each = [&](const Course& c) {
+            if (c.number.substr(0, prefix.size()) != prefix) return false;
+            fn(c);
+            return true;
+        };
+        scanFrom(prefix, each);
+    }
+};
+
+// ---------- Balanced (AVL) Binary Search Tree keyed by course number ----------
+//
+// Registrar exports are usually already sorted, which turns a plain BST into a
+// linked list. The AVL invariant (child heights differ by at most one) keeps
+// every operation O(log n) regardless of input order, and all walks below are
+// iterative so very large catalogs cannot overflow the call stack.
+
+struct Node {
+    CourseKey key; // course->key, so a descent reads only nodes
+    const Course* course;
+    Node* left{nullptr};
+    Node* right{nullptr};
+    int height{1};
+    uint32_t owner; // CourseBST::stamp_ of the tree that made the node
+    Node(const Course* c, uint32_t by) : key(c->key), course(c), owner(by) {}
+};
+
+// Nodes come from the arena the tree is given and are freed with it. Edits
+// never change a node another tree can reach: insertOrAssign and erase copy
+// the nodes on their path (and any they rotate) unless this tree made them. A
+// tree started from another one shares all of its nodes, and after k edits
+// owns O(k log n) of them, while readers of the original see no change.
+class CourseBST final : public CourseStore {
+    // An AVL tree of height 96 would need more nodes than fit in memory.
+    static constexpr int kMaxHeight = 96;
+
+public:
+    // Forward in-order iterator. Nodes have no parent links, so it carries the
+    // stack of ancestors still to be visited (bounded by the tree height).
+    class Iterator {
+    public:
+        const Course& operator*() const { return *stack_[top_ - 1]->course; }
+        const Course* operator->() const { return stack_[top_ - 1]->course; }
+
+        Iterator& operator++() {
+            const Node* n = stack_[--top_]->right;
+            pushLeftSpine(n);
+            return *this;
+        }
+
+        bool operator==(const Iterator& o) const {
+            return top_ == o.top_ && (top_ == 0 || stack_[top_ - 1] == o.stack_[o.top_ - 1]);
+        }
+        bool operator!=(const Iterator& o) const { return !(*this == o); }
+
+    private:
+        friend class CourseBST;
+
+        const Node* stack_[kMaxHeight];
+        int top_{0};
+
+        void pushLeftSpine(const Node* n) {
+            for (; n; n = n->left) stack_[top_++] = n;
+        }
+    };
+
+    explicit CourseBST(Arena& arena) : arena_(arena) {}
+
+    // Starts as `base`, sharing every node. `base` may be read concurrently and
+    // must outlive this tree; neither edits touch it.
+    CourseBST(Arena& arena, const CourseBST& base) : arena_(arena), root_(base.root_), count_(base.count_) {}
+
+    CourseBST(const CourseBST&) = delete;
+    CourseBST& operator=(const CourseBST&) = delete;
+
+    const char* kind() const override { return "avl"; }
+    size_t size() const override { return count_; }
+    int height() const override { return heightOf(root_); }
+
+    // Insert or replace: a new number gets a node, an existing one is pointed
+    // at `c` instead. `c` must outlive the tree.
+    void insertOrAssign(const Course* c) {
+        // Links from the root down to the insertion point, for rebalancing.
+        Node** path[kMaxHeight];
+        int depth = 0;
+
+        Node** link = &root_;
+        while (*link) {
+            Node* n = *link = own(*link);
+            const int cmp = compare(c->key, c->number, n);
+            if (cmp == 0) {
+                n->key = c->key;
+                n->course = c;
+                return;
+            }
+            path[depth++] = link;
+            link = cmp < 0 ? &n->left : &n->right;
+        }
+
+        *link = arena_.make<Node>(c, stamp_);
+        ++count_;
+
+        // Walk back up; once a subtree's height is unchanged nothing above it moves.
+        while (depth > 0) {
+            Node** up = path[--depth];
+            int before = (*up)->height;
+            *up = rebalance(*up);
+            if ((*up)->height == before) break;
+        }
+    }
+
+    // Removes the course with this number, if present. Nodes are relinked rather
+    // than having payloads swapped, so a removal moves no other course.
+    bool erase(std::string_view number) {
+        if (!find(number)) return false; // so a miss copies nothing
+        Node** path[kMaxHeight];
+        int depth = 0;
+
+        const CourseKey key = CourseKey::from(number);
+        Node** link = &root_;
+        for (;;) {
+            Node* n = *link = own(*link);
+            const int cmp = compare(key, number, n);
+            if (cmp == 0) break;
+            path[depth++] = link;
+            link = cmp < 0 ? &n->left : &n->right;
+        }
+        Node* victim = *link;
+
+        if (!victim->left || !victim->right) {
+            *link = victim->left ? victim->left : victim->right;
+        } else {
+            // Detach the in-order successor and put it where the victim was.
+            const int victimDepth = depth;
+            path[depth++] = link;
+            Node** s = &victim->right;
+            while ((*s)->left) {
+                *s = own(*s);
+                path[depth++] = s;
+                s = &(*s)->left;
+            }
+            Node* succ = own(*s);
+            *s = succ->right;
+            succ->left = victim->left;
+            succ->right = victim->right;
+            *link = succ;
+            // The link below the victim now hangs off the successor.
+            if (depth > victimDepth + 1) path[victimDepth + 1] = &succ->right;
+        }
+        --count_;
+
+        // A deletion can shrink every subtree on the path, so rebalance all of it.
+        while (depth > 0) {
+            Node** up = path[--depth];
+            *up = rebalance(*up);
+        }
+        return true;
+    }
+
+    // Replaces the contents with a perfectly balanced tree in one O(n) pass.
+    // `sorted` must be strictly ascending by course number (no duplicates), and
+    // its records must outlive the tree; they are not copied.
+    void buildFromSorted(const std::vector<const Course*>& sorted) override {
+        // Old nodes are abandoned in place; the arena is not released because
+        // other trees may share them.
+        root_ = nullptr;
+
+        // Pending [lo, hi) ranges and the link each range's root hangs from.
+        struct Range {
+            size_t lo, hi;
+            Node** link;
+        };
+        Range work[kMaxHeight + 1];
+        int top = 0;
+        work[top++] = {0, sorted.size(), &root_};
+
+        while (top > 0) {
+            Range r = work[--top];
+            if (r.lo == r.hi) continue;
+            size_t mid = r.lo + (r.hi - r.lo) / 2;
+            Node* n = arena_.make<Node>(sorted[mid], stamp_);
+            // A midpoint split of k keys always yields height bitWidth(k).
+            n->height = bitWidth(r.hi - r.lo);
+            *r.link = n;
+            work[top++] = {r.lo, mid, &n->left};
+            work[top++] = {mid + 1, r.hi, &n->right};
+        }
+        count_ = sorted.size();
+    }
+
+    // Shares this tree's nodes and applies the edits to the copy: O(k log n)
+    // new nodes for k edits.
+    std::unique_ptr<CourseStore> edited(Arena& arena, const std::vector<const Course*>&,
+                                        const std::vector<CourseEdit>& edits) const override {
+        auto tree = std::make_unique<CourseBST>(arena, *this);
+        for (const CourseEdit& e : edits) {
+            if (e.after) {
+                tree->insertOrAssign(e.after);
+            } else {
+                tree->erase(e.before->number);
+            }
+        }
+        return tree;
+    }
+
+    size_t heapBytes() const override { return 0; }
+
+    const Course* find(std::string_view number) const override {
+        const CourseKey key = CourseKey::from(number);
+        const Node* cur = root_;
+        while (cur) {
+            const int cmp = compare(key, number, cur);
+            if (cmp == 0) return cur->course;
+            cur = cmp < 0 ? cur->left : cur->right;
+        }
+        return nullptr;
+    }
+
+    Iterator begin() const {
+        Iterator it;
+        it.pushLeftSpine(root_);
+        return it;
+    }
+
+    Iterator end() const { return Iterator(); }
+
+    // First course whose number is >= `number` (lowerBound) or > `number`
+    // (upperBound). Each costs one root-to-leaf descent.
+    Iterator lowerBound(std::string_view number) const { return bound(number, false); }
+    Iterator upperBound(std::string_view number) const { return bound(number, true); }
+
+    // Touches only the visited keys and the O(log n) nodes on the way to the
+    // first of them.
+    void scanFrom(std::string_view from, CourseVisitor fn) const override {
+        for (Iterator it = lowerBound(from), stop = end(); it != stop && fn(*it);) ++it;
+    }
+
+private:
+    Arena& arena_;
+    Node* root_{nullptr};
+    size_t count_{0};
+    const uint32_t stamp_ = nextStamp();
+
+    static uint32_t nextStamp() {
+        static std::atomic<uint32_t> trees{0};
+        return trees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Number order of (key, number) against `n`'s course; the strings are read
+    // only for a long key that ties with the node's.
+    static int compare(const CourseKey& key, std::string_view number, const Node* n) {
+        if (key != n->key) return key < n->key ? -1 : 1;
+        if (key.packed()) return 0;
+        return number.compare(n->course->number);
+    }
+
+    // `n` itself if this tree made it, else a copy this tree may edit.
+    Node* own(Node* n) {
+        if (n->owner == stamp_) return n;
+        Node* copy = arena_.make<Node>(*n);
+        copy->owner = stamp_;
+        return copy;
+    }
+
+    Iterator bound(std::string_view number, bool strict) const {
+        // Every node we step left from is a candidate; the last one pushed is
+        // the answer, and the ones below it on the stack are its successors.
+        const CourseKey key = CourseKey::from(number);
+        Iterator it;
+        for (const Node* n = root_; n;) {
+            const int cmp = compare(key, number, n);
+            if (strict ? cmp < 0 : cmp <= 0) {
+                it.stack_[it.top_++] = n;
+                n = n->left;
+            } else {
+                n = n->right;
+            }
+        }
+        return it;
+    }
+
+    static int heightOf(const Node* n) { return n ? n->height : 0; }
+
+    static void updateHeight(Node* n) {
+        n->height = 1 + std::max(heightOf(n->left), heightOf(n->right));
+    }
+
+    // Rotations take a node this tree owns and copy the child they lift.
+    Node* rotateLeft(Node* n) {
+        Node* r = own(n->right);
+        n->right = r->left;
+        r->left = n;
+        updateHeight(n);
+        updateHeight(r);
+        return r;
+    }
+
+    Node* rotateRight(Node* n) {
+        Node* l = own(n->left);
+        n->left = l->right;
+        l->right = n;
+        updateHeight(n);
+        updateHeight(l);
+        return l;
+    }
+
+    // Restores the AVL invariant at an owned n and returns the new subtree root.
+    Node* rebalance(Node* n) {
+        updateHeight(n);
+        int balance = heightOf(n->left) - heightOf(n->right);
+        if (balance > 1) {
+            if (heightOf(n->left->left) < heightOf(n->left->right)) n->left = rotateLeft(own(n->left));
+            return rotateRight(n);
+        }
+        if (balance < -1) {
+            if (heightOf(n->right->right) < heightOf(n->right->left)) n->right = rotateRight(own(n->right));
+            return rotateLeft(n);
+        }
+        return n;
+    }
+};
+
+// ---------- Flat sorted course store ----------
+//
+// A loaded catalog is only ever read, so it does not need a node per course.
+// This store keeps the courses in one array in key order and searches a
+// separate array of their CourseKeys laid out in Eytzinger (breadth-first)
+// order: each probe is a pair of integer compares with no
+// data-dependent branch, a node's children sit side by side, and the top
+// levels of the search stay in cache.
+
+class FlatCourseStore final : public CourseStore {
+public:
+    // Position in key order; it stays valid as long as the store is unchanged.
+    class Iterator {
+    public:
+        const Course& operator*() const { return *(*courses_)[r_]; }
+        const Course* operator->() const { return (*courses_)[r_]; }
+
+        Iterator& operator++() {
+            ++r_;
+            return *this;
+        }
+
+        bool operator==(const Iterator& o) const { return r_ == o.r_; }
+        bool operator!=(const Iterator& o) const { return r_ != o.r_; }
+
+    private:
+        friend class FlatCourseStore;
+
+        Iterator(const std::vector<const Course*>* courses, size_t r) : courses_(courses), r_(r) {}
+
+        const std::vector<const Course*>* courses_;
+        size_t r_;
+    };
+
+    const char* kind() const override { return "flat"; }
+    size_t size() const override { return courses_.size(); }
+    int height() const override { return bitWidth(courses_.size()); }
+
+    void buildFromSorted(const std::vector<const Course*>& sorted) override {
+        const size_t n = sorted.size();
+        courses_ = sorted;
+        keys_.assign(n + 1, CourseKey{});
+        slotCourses_.assign(n + 1, nullptr);
+        rank_.assign(n + 1, 0);
+
+        // In-order walk of the implicit tree (children of k are 2k and 2k+1),
+        // handing out sorted positions as it goes.
+        size_t k = 1;
+        while (2 * k <= n) k *= 2;
+        for (size_t i = 0; i < n; ++i) {
+            keys_[k] = courses_[i]->key;
+            slotCourses_[k] = courses_[i];
+            rank_[k] = static_cast<uint32_t>(i);
+            if (2 * k + 1 <= n) {
+                for (k = 2 * k + 1; 2 * k <= n;) k *= 2;
+            } else {
+                while (k & 1) k >>= 1;
+                k >>= 1;
+            }
+        }
+    }
+
+    // The arrays hold no record of their own, but every slot can move, so an
+    // edit is a rebuild.
+    std::unique_ptr<CourseStore> edited(Arena&, const std::vector<const Course*>& sorted,
+                                        const std::vector<CourseEdit>&) const override {
+        auto flat = std::make_unique<FlatCourseStore>();
+        flat->buildFromSorted(sorted);
+        return flat;
+    }
+
+    size_t heapBytes() const override {
+        return courses_.capacity() * sizeof(const Course*) + keys_.capacity() * sizeof(CourseKey) +
+               slotCourses_.capacity() * sizeof(const Course*) + rank_.capacity() * sizeof(uint32_t);
+    }
+
+    const Course* find(std::string_view number) const override {
+        const CourseKey key = CourseKey::from(number);
+        return matchExit(exitSlot(key), key, number);
+    }
+
+    // One search alone stalls on a cache miss at nearly every level of a large
+    // catalog. Here up to kLanes searches descend in lock step (all of them take
+    // the same number of levels, give or take the last), so the loads of one
+    // level are in flight together and each lane's prefetch covers it four
+    // levels ahead.
+    void findMany(Span<std::string_view> numbers, const Course** out) const override {
+        constexpr size_t kLanes = 16;
+        const size_t n = courses_.size();
+        CourseKey keys[kLanes];
+        size_t slots[kLanes];
+        for (size_t base = 0; base < numbers.size(); base += kLanes) {
+            const size_t lanes = std::min(kLanes, numbers.size() - base);
+            for (size_t i = 0; i < lanes; ++i) {
+                keys[i] = CourseKey::from(numbers[base + i]);
+                slots[i] = 1;
+            }
+            for (bool descending = n > 0; descending;) {
+                descending = false;
+                for (size_t i = 0; i < lanes; ++i) {
+                    const size_t k = slots[i];
+                    if (k > n) continue;
+#if defined(__GNUC__)
+                    __builtin_prefetch(keys_.data() + std::min(16 * k, n));
+#endif
+                    slots[i] = 2 * k + less(keys_[k], keys[i]);
+                    descending = true;
+                }
+            }
+            for (size_t i = 0; i < lanes; ++i) out[base + i] = matchExit(slots[i], keys[i], numbers[base + i]);
+        }
+    }
+
+    Iterator begin() const { return Iterator(&courses_, 0); }
+    Iterator end() const { return Iterator(&courses_, courses_.size()); }
+
+    // First course whose number is >= `number` (lowerBound) or > `number`
+    // (upperBound), from one branch-free descent.
+    Iterator lowerBound(std::string_view number) const {
+        return Iterator(&courses_, lowerRank(CourseKey::from(number), number));
+    }
+    Iterator upperBound(std::string_view number) const {
+        const CourseKey key = CourseKey::from(number);
+        size_t r = lowerRank(key, number);
+        if (matchAt(r, key, number)) ++r;
+        return Iterator(&courses_, r);
+    }
+
+    void scanFrom(std::string_view from, CourseVisitor fn) const override {
+        for (Iterator it = lowerBound(from), stop = end(); it != stop && fn(*it);) ++it;
+    }
+
+private:
+    std::vector<const Course*> courses_;     // key order
+    std::vector<CourseKey> keys_;            // Eytzinger order, 1-based
+    std::vector<const Course*> slotCourses_; // Eytzinger slot -> its course
+    std::vector<uint32_t> rank_;             // Eytzinger slot -> index into courses_
+
+    // operator< without the short-circuit branch.
+    static bool less(const CourseKey& a, const CourseKey& b) {
+        return (a.hi < b.hi) | ((a.hi == b.hi) & (a.lo < b.lo));
+    }
+
+    // Slot where a branch-free descent for `key` leaves the tree (past the
+    // last level).
+    size_t exitSlot(const CourseKey& key) const {
+        const size_t n = courses_.size();
+        size_t k = 1;
+        while (k <= n) {
+#if defined(__GNUC__)
+            // Four levels down, k's 16 descendants are adjacent (four cache lines).
+            __builtin_prefetch(keys_.data() + std::min(16 * k, n));
+#endif
+            k = 2 * k + less(keys_[k], key);
+        }
+        return k;
+    }
+
+    // The slot of the first key >= the searched one (0 if none), from the slot
+    // its descent exited at. Strip the trailing right turns and the left turn
+    // above them: that node is the last one the search went left from.
+    static size_t lastLeft(size_t k) {
+#if defined(__GNUC__)
+        k >>= __builtin_ctzll(~static_cast<unsigned long long>(k)) + 1;
+#else
+        while (k & 1) k >>= 1;
+        k >>= 1;
+#endif
+        return k;
+    }
+
+    // Index of the first course whose number is >= `number` (size() if none).
+    size_t lowerRank(const CourseKey& key, std::string_view number) const {
+        const size_t k = lastLeft(exitSlot(key));
+        return settle(k ? rank_[k] : courses_.size(), key, number);
+    }
+
+    // find()'s answer from the slot its descent exited at. A packed key is
+    // settled by the key already in cache, so a miss reads no course at all.
+    const Course* matchExit(size_t exit, const CourseKey& key, std::string_view number) const {
+        const size_t k = lastLeft(exit);
+        if (key.packed()) return k && keys_[k] == key ? slotCourses_[k] : nullptr;
+        return matchAt(settle(k ? rank_[k] : courses_.size(), key, number), key, number);
+    }
+
+    // A long number can tie with a few neighbours on its packed prefix; those
+    // are contiguous from r, so step past the ones that sort before `number`.
+    size_t settle(size_t r, const CourseKey& key, std::string_view number) const {
+        if (!key.packed()) {
+            while (r < courses_.size() && numberLess(courses_[r]->key, courses_[r]->number, key, number)) ++r;
+        }
+        return r;
+    }
+
+    const Course* matchAt(size_t r, const CourseKey& key, std::string_view number) const {
+        if (r == courses_.size()) return nullptr;
+        const Course* c = courses_[r];
+        return numberEqual(key, number, c->key, c->number) ? c : nullptr;
+    }
+};
+
+// Which store backs newly loaded catalogs (--store).
+enum class StoreKind { kAvl, kFlat };
+
+static bool parseStoreKind(std::string_view name, StoreKind& kind) {
+    if (name == "avl") {
+        kind = StoreKind::kAvl;
+    } else if (name == "flat") {
+        kind = StoreKind::kFlat;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static std::unique_ptr<CourseStore> makeCourseStore(StoreKind kind, Arena& arena) {
+    if (kind == StoreKind::kFlat) return std::make_unique<FlatCourseStore>();
+    return std::make_unique<CourseBST>(arena);
+}
+
+// ---------- Chunked CSV parsing ----------
+//
+// Large files are cut at newline boundaries and each chunk is tokenized on its
+// own thread into plain views. Interning and arena commits happen afterwards in
+// one ordered pass, so duplicate handling and warning order match a serial load.
+
+// Progress of one load (see CoursePlanner::loadFromFile). The loading threads
+// write the counters and any other thread may read them while it runs; setting
+// `cancel` makes the load give up at its next check and leave the published
+// catalog as it was.
+struct LoadProgress {
+    std::atomic<uint64_t> bytesTotal{0};
+    std::atomic<uint64_t> bytesParsed{0};
+    std::atomic<uint64_t> rows{0};     // rows parsed so far, duplicates included
+    std::atomic<size_t> phase{0};      // the PlannerStats::Phase under way
+    std::atomic<bool> cancel{false};
+    std::ostream* messages{nullptr};   // if set, gets the load's warnings and summary
+};
+
+struct ParsedRow {
+    size_t line;              // 1-based, relative to the start of its chunk
+    std::string_view number;  // uppercased; points into the file or chunk scratch
+    std::string_view title;
+    size_t firstPrereq;       // index into ParsedChunk::prereqs
+    size_t prereqCount;
+};
+
+struct ParsedChunk {
+    std::string_view text;
+    size_t lines{0};
+    std::vector<ParsedRow> rows;
+    std::vector<std::string_view> prereqs;
+    std::vector<size_t> badLines;  // relative line numbers of malformed rows
+    Arena scratch;                 // uppercased copies of fields that needed it
+    LoadProgress* progress{nullptr};
+};
+
+// Returns `raw` itself when it is already uppercase, otherwise an uppercased copy.
+static std::string_view upperView(std::string_view raw, Arena& scratch, const TextKernels& text) {
+    const size_t first = text.findLower(raw.data(), raw.size());
+    if (first == raw.size()) return raw;
+    char* dst = static_cast<char*>(scratch.allocate(raw.size(), 1));
+    std::memcpy(dst, raw.data(), first);
+    text.upperAscii(raw.data() + first, dst + first, raw.size() - first);
+    return {dst, raw.size()};
+}
+
+static void parseChunk(ParsedChunk& chunk) {
+    const TextKernels& text = textKernels();
+    const char* const buf = chunk.text.data();
+    const size_t size = chunk.text.size();
+    std::vector<std::string_view> parts;
+    size_t pos = 0;
+
+    // Progress goes out every 64 KiB, which is also how soon a cancelled load
+    // stops parsing.
+    constexpr size_t kReportBytes = 64 * 1024;
+    size_t reportedPos = 0, reportedRows = 0;
+    auto report = [&] {
+        const size_t at = std::min(pos, size);
+        chunk.progress->bytesParsed.fetch_add(at - reportedPos, std::memory_order_relaxed);
+        chunk.progress->rows.fetch_add(chunk.rows.size() - reportedRows, std::memory_order_relaxed);
+        reportedPos = at;
+        reportedRows = chunk.rows.size();
+        return !chunk.progress->cancel.load(std::memory_order_relaxed);
+    };
+
+    while (pos < size) {
+        if (chunk.progress && pos - reportedPos >= kReportBytes && !report()) return;
+
+        // One line, field by field: each step jumps to the next ',' or '\n'.
+        // Titles do not contain commas (per the assignment files).
+        parts.clear();
+        size_t end;
+        for (;;) {
+            end = pos + text.findDelimiter(buf + pos, size - pos);
+            parts.push_back(trimView({buf + pos, end - pos}));
+            pos = end + 1;
+            if (end == size || buf[end] == '\n') break;
+        }
+
+        ++chunk.lines;
+        // Like trimming the line and splitting it with std::getline: a blank
+        // line has no fields, and a trailing comma adds no empty field.
+        if (parts.back().empty()) parts.pop_back();
+        if (parts.empty()) continue; // allow blank lines
+        if (parts.size() < 2) {
+            chunk.badLines.push_back(chunk.lines);
+            continue;
+        }
+
+        // Normalize course numbers to uppercase for consistent keys; remaining
+        // parts (if any) are prerequisites.
+        ParsedRow row{chunk.lines, upperView(parts[0], chunk.scratch, text), parts[1], chunk.prereqs.size(), 0};
+        for (size_t i = 2; i < parts.size(); ++i) {
+            if (parts[i].empty()) continue;
+            chunk.prereqs.push_back(upperView(parts[i], chunk.scratch, text));
+            ++row.prereqCount;
+        }
+        chunk.rows.push_back(row);
+    }
+    if (chunk.progress) report();
+}
+
+// Splits `buf` into line-aligned chunks and parses them, in parallel when the
+// input is big enough to be worth the threads. A cancelled `progress` leaves
+// the chunks partly parsed.
+static void parseChunks(std::string_view buf, std::vector<ParsedChunk>& chunks, LoadProgress* progress = nullptr) {
+    constexpr size_t kMinChunkBytes = 1 << 20;
+    size_t workers = std::max<size_t>(1, std::thread::hardware_concurrency());
+    workers = std::max<size_t>(1, std::min(workers, buf.size() / kMinChunkBytes));
+
+    chunks = std::vector<ParsedChunk>(workers);
+    size_t begin = 0;
+    for (size_t i = 0; i < workers; ++i) {
+        size_t end = buf.size();
+        if (i + 1 < workers) {
+            end = std::max(begin, buf.size() / workers * (i + 1));
+            end = buf.find('\n', end);
+            end = (end == std::string_view::npos) ? buf.size() : end + 1;
+        }
+        chunks[i].text = buf.substr(begin, end - begin);
+        chunks[i].progress = progress;
+        begin = end;
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < workers; ++i) {
+        try {
+            threads.emplace_back(parseChunk, std::ref(chunks[i]));
+        } catch (const std::system_error&) {
+            parseChunk(chunks[i]); // no thread available; parse inline
+        }
+    }
+    parseChunk(chunks[0]);
+    for (std::thread& t : threads) t.join();
+}
+
+// ---------- Prerequisite graph ----------
+//
+// Direct prereq edges for every interned id. The prereqs of id v are the list
+// in its course record, found through an id -> course table; ids that were
+// never defined as a course have no record and no outgoing edges. The reverse
+// edges (which courses list v as a prereq) are kept per id as spans into the
+// arena, so "what does v unlock" is an index lookup instead of a scan of every
+// course. Both tables are copy-on-write: a graph built as an edit of another
+// shares them and rewrites only the entries of ids whose course or dependents
+// changed. Traversals stamp visited vertices with a per-query epoch, so a query
+// costs O(size of its answer) with no clearing. The stamps are per thread, so a
+// built graph can be queried concurrently.
+
+class PrereqGraph {
+public:
+    // `sorted` lists the defined courses in course-number order; each id's
+    // dependents are stored in that order, once each even if a course repeats
+    // the prereq.
+    void build(Arena& arena, size_t vertexCount, const std::vector<const Course*>& sorted) {
+        courses_.resize(vertexCount, arena);
+        for (const Course* c : sorted) courses_.mutableAt(c->id, arena) = c;
+
+        // Counting sort of the forward edges by target into one arena array.
+        // `last` remembers the dependent most recently added to each list to
+        // drop repeats.
+        std::vector<CourseId> last(vertexCount, kNoCourse);
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (const Course* c : sorted) {
+            for (CourseId p : c->prereqs) {
+                if (last[p] == c->id) continue;
+                last[p] = c->id;
+                ++offsets[p + 1];
+            }
+        }
+        for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+        const size_t total = offsets[vertexCount];
+        CourseId* edges = total ? static_cast<CourseId*>(arena.allocate(sizeof(CourseId) * total, alignof(CourseId)))
+                                : nullptr;
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        std::fill(last.begin(), last.end(), kNoCourse);
+        for (const Course* c : sorted) {
+            for (CourseId p : c->prereqs) {
+                if (last[p] == c->id) continue;
+                last[p] = c->id;
+                edges[fill[p]++] = c->id;
+            }
+        }
+        dependents_.resize(vertexCount, arena);
+        for (size_t v = 0; v < vertexCount; ++v) {
+            if (offsets[v + 1] == offsets[v]) continue;
+            dependents_.mutableAt(v, arena) = {edges + offsets[v], offsets[v + 1] - offsets[v]};
+        }
+    }
+
+    // Builds the graph as `base` with `edits` applied, over `vertexCount` ids
+    // (at least as many as base has). Only the dependents of prereqs a course
+    // gained or dropped are rewritten; everything else is shared with base.
+    void edit(Arena& arena, const PrereqGraph& base, size_t vertexCount, const std::vector<CourseEdit>& edits) {
+        courses_.shareFrom(base.courses_);
+        courses_.resize(vertexCount, arena);
+        dependents_.shareFrom(base.dependents_);
+        dependents_.resize(vertexCount, arena);
+
+        // Every edge that appears or disappears, as (prereq, course).
+        struct EdgeChange {
+            CourseId prereq;
+            CourseId course;
+            bool gained;
+        };
+        std::vector<EdgeChange> changes;
+        std::vector<CourseId> was, now;
+        auto distinct = [](const Course* c, std::vector<CourseId>& out) {
+            out.clear();
+            if (c) out.assign(c->prereqs.begin(), c->prereqs.end());
+            std::sort(out.begin(), out.end());
+            out.erase(std::unique(out.begin(), out.end()), out.end());
+        };
+        for (const CourseEdit& e : edits) {
+            const CourseId id = (e.after ? e.after : e.before)->id;
+            courses_.mutableAt(id, arena) = e.after;
+            distinct(e.before, was);
+            distinct(e.after, now);
+            size_t i = 0, j = 0;
+            while (i < was.size() || j < now.size()) {
+                if (j == now.size() || (i < was.size() && was[i] < now[j])) {
+                    changes.push_back({was[i++], id, false});
+                } else if (i == was.size() || now[j] < was[i]) {
+                    changes.push_back({now[j++], id, true});
+                } else {
+                    ++i;
+                    ++j;
+                }
+            }
+        }
+        std::sort(changes.begin(), changes.end(),
+                  [](const EdgeChange& a, const EdgeChange& b) { return a.prereq < b.prereq; });
+
+        // Rewrite each touched list: drop the courses that left it and merge in
+        // the ones that joined, keeping course-number order.
+        auto byNumber = [&](CourseId a, CourseId b) { return internedLess(*courses_[a], *courses_[b]); };
+        std::vector<CourseId> gone, joined, kept, merged;
+        for (size_t k = 0; k < changes.size();) {
+            const CourseId p = changes[k].prereq;
+            gone.clear();
+            joined.clear();
+            for (; k < changes.size() && changes[k].prereq == p; ++k) {
+                (changes[k].gained ? joined : gone).push_back(changes[k].course);
+            }
+            std::sort(gone.begin(), gone.end());
+            std::sort(joined.begin(), joined.end(), byNumber);
+            kept.clear();
+            for (CourseId d : dependents(p)) {
+                if (!std::binary_search(gone.begin(), gone.end(), d)) kept.push_back(d);
+            }
+            merged.clear();
+            std::merge(kept.begin(), kept.end(), joined.begin(), joined.end(), std::back_inserter(merged), byNumber);
+            dependents_.mutableAt(p, arena) = {arena.copyArray(merged.data(), merged.size()), merged.size()};
+        }
+    }
+
+    size_t vertexCount() const { return courses_.size(); }
+
+    // The course defined under id v, or null for an id only named as a prereq.
+    const Course* course(CourseId v) const { return courses_[v]; }
+
+    Span<CourseId> prereqs(CourseId v) const {
+        const Course* c = courses_[v];
+        return c ? c->prereqs : Span<CourseId>();
+    }
+
+    // Courses that list `v` as a direct prereq, in course-number order.
+    Span<CourseId> dependents(CourseId v) const { return dependents_[v]; }
+
+    // Heap bytes outside the arena.
+    size_t heapBytes() const { return courses_.heapBytes() + dependents_.heapBytes(); }
+
+    // Appends every course that needs `v` directly or through other courses
+    // to `out`, each once and in no particular order. `v` itself is left out
+    // even when it sits on a prereq cycle.
+    void dependentClosure(CourseId v, std::vector<CourseId>& out) const {
+        Visits& visits = threadVisits();
+        if (visits.seen.size() < vertexCount()) visits.seen.resize(vertexCount(), 0);
+        std::vector<uint32_t>& seen = visits.seen;
+        const uint32_t mark = visits.nextEpoch();
+        seen[v] = mark;
+        const size_t first = out.size();
+        for (CourseId d : dependents(v)) {
+            seen[d] = mark;
+            out.push_back(d);
+        }
+        // `out` past `first` doubles as the BFS queue.
+        for (size_t i = first; i < out.size(); ++i) {
+            for (CourseId d : dependents(out[i])) {
+                if (seen[d] == mark) continue;
+                seen[d] = mark;
+                out.push_back(d);
+            }
+        }
+    }
+
+    // Appends every course that must be taken before `v` to `out`, each one
+    // after all of its own prereqs (so `out` is a valid order to take them in).
+    // A prereq cycle cannot loop: each course is emitted at most once.
+    void closure(CourseId v, std::vector<CourseId>& out) const {
+        Visits& visits = threadVisits();
+        if (visits.seen.size() < vertexCount()) visits.seen.resize(vertexCount(), 0);
+        std::vector<uint32_t>& seen = visits.seen;
+        const uint32_t mark = visits.nextEpoch();
+        struct Frame {
+            CourseId v;
+            uint32_t next; // position in v's prereq list
+        };
+        std::vector<Frame> stack;
+        seen[v] = mark;
+        stack.push_back({v, 0});
+        while (!stack.empty()) {
+            Frame& f = stack.back();
+            Span<CourseId> pre = prereqs(f.v);
+            if (f.next < pre.size()) {
+                CourseId p = pre[f.next++];
+                if (seen[p] != mark) {
+                    seen[p] = mark;
+                    stack.push_back({p, 0});
+                }
+                continue;
+            }
+            if (f.v != v) out.push_back(f.v);
+            stack.pop_back();
+        }
+    }
+
+    // Appends to `out` every course that is both reachable from one of `from`
+    // along prereq edges and leads back to one of them, `from` included (ids
+    // past vertexCount() are skipped). Any prereq cycle through one of `from`
+    // lies entirely within this set.
+    void between(const std::vector<CourseId>& from, std::vector<CourseId>& out) const {
+        Visits& visits = threadVisits();
+        if (visits.seen.size() < vertexCount()) visits.seen.resize(vertexCount(), 0);
+        std::vector<uint32_t>& seen = visits.seen;
+        const uint32_t mark = visits.nextEpoch();
+        std::vector<CourseId> stack;
+        for (CourseId c : from) {
+            if (c >= vertexCount() || seen[c] == mark) continue;
+            seen[c] = mark;
+            stack.push_back(c);
+        }
+        while (!stack.empty()) {
+            const CourseId v = stack.back();
+            stack.pop_back();
+            for (CourseId p : prereqs(v)) {
+                if (seen[p] == mark) continue;
+                seen[p] = mark;
+                stack.push_back(p);
+            }
+        }
+        // Walk back from `from` through the marked courses only; a course
+        // drops its mark (stamp 0 matches no epoch) as it joins `out`.
+        const size_t first = out.size();
+        for (CourseId c : from) {
+            if (c >= vertexCount() || seen[c] != mark) continue;
+            seen[c] = 0;
+            out.push_back(c);
+        }
+        for (size_t i = first; i < out.size(); ++i) {
+            for (CourseId d : dependents(out[i])) {
+                if (seen[d] != mark) continue;
+                seen[d] = 0;
+                out.push_back(d);
+            }
+        }
+    }
+
+    // Tarjan's strongly connected components of the subgraph `vertices`
+    // induces (edges leaving it are ignored), without recursion. Calls
+    // emit(members, cyclic) once per component, each after every component it
+    // has prereqs in; `cyclic` is set for a component of more than one course
+    // or a course that lists itself. `vertices` must not repeat an id.
+    template <typename Emit>
+    void components(const std::vector<CourseId>& vertices, Emit&& emit) const {
+        constexpr uint32_t kOutside = UINT32_MAX;
+        constexpr uint32_t kUnvisited = UINT32_MAX;
+        const size_t m = vertices.size();
+        std::vector<uint32_t> local(vertexCount(), kOutside); // id -> position in `vertices`
+        for (size_t i = 0; i < m; ++i) local[vertices[i]] = static_cast<uint32_t>(i);
+
+        std::vector<uint32_t> index(m, kUnvisited), low(m, 0);
+        std::vector<uint8_t> finished(m, 0);
+        std::vector<uint32_t> sccStack;
+        std::vector<CourseId> members;
+        struct Frame {
+            uint32_t v;
+            uint32_t next; // position in v's prereq list
+        };
+        std::vector<Frame> calls;
+        uint32_t counter = 0;
+
+        for (uint32_t root = 0; root < m; ++root) {
+            if (index[root] != kUnvisited) continue;
+            auto open = [&](uint32_t v) {
+                index[v] = low[v] = counter++;
+                sccStack.push_back(v);
+                calls.push_back({v, 0});
+            };
+            open(root);
+
+            while (!calls.empty()) {
+                Frame& f = calls.back();
+                Span<CourseId> pre = prereqs(vertices[f.v]);
+                if (f.next < pre.size()) {
+                    const uint32_t w = local[pre[f.next++]];
+                    if (w == kOutside) continue;
+                    if (index[w] == kUnvisited) {
+                        open(w); // invalidates f
+                    } else if (!finished[w]) { // still on the SCC stack
+                        low[f.v] = std::min(low[f.v], index[w]);
+                    }
+                    continue;
+                }
+
+                const uint32_t v = f.v;
+                calls.pop_back();
+                if (!calls.empty()) low[calls.back().v] = std::min(low[calls.back().v], low[v]);
+                if (low[v] != index[v]) continue;
+
+                // v roots a component: pop it and hand it out.
+                size_t start = sccStack.size();
+                while (sccStack[--start] != v) {}
+                const bool cyclic = sccStack.size() - start > 1 ||
+                                    std::find(pre.begin(), pre.end(), vertices[v]) != pre.end();
+                members.clear();
+                for (size_t k = start; k < sccStack.size(); ++k) {
+                    finished[sccStack[k]] = 1;
+                    members.push_back(vertices[sccStack[k]]);
+                }
+                sccStack.resize(start);
+                emit(members, cyclic);
+            }
+        }
+    }
+
+private:
+    CowTable<const Course*> courses_;      // id -> defined course, or null
+    CowTable<Span<CourseId>> dependents_;  // id -> courses that list it, in number order
+
+    // Stamps only ever grow within a thread, so they stay valid across graphs.
+    struct Visits {
+        std::vector<uint32_t> seen;
+        uint32_t epoch{0};
+
+        uint32_t nextEpoch() {
+            if (++epoch == 0) { // wrapped: stale stamps could collide, so clear them
+                std::fill(seen.begin(), seen.end(), 0);
+                epoch = 1;
+            }
+            return epoch;
+        }
+    };
+
+    static Visits& threadVisits() {
+        thread_local Visits visits;
+        return visits;
+    }
+};
+
+// ---------- Closure cache ----------
+//
+// Memoized transitive closures for one catalog. A chain or dependents query for
+// a gateway course walks and sorts a large part of the graph, and the same few
+// courses are asked about over and over, so each answer is kept once computed.
+// The slot table is allocated by the first query. A filled slot never changes,
+// so readers take it with one acquire load; two threads missing on the same
+// course both compute it and the later one discards its copy. A budget caps
+// the ids held, and past it answers are computed per query as before. The
+// cache lives and dies with its catalog, so each published catalog starts
+// with an empty one.
+
+class ClosureCache {
+public:
+    static constexpr size_t kDefaultBudget = size_t{1} << 22; // ids, 16 MiB
+
+    ClosureCache() = default;
+    ClosureCache(const ClosureCache&) = delete;
+    ClosureCache& operator=(const ClosureCache&) = delete;
+    ~ClosureCache() {
+        for (size_t v = 0; v < size_; ++v) delete slots_[v].load(std::memory_order_relaxed);
+    }
+
+    // The closure of `v` among `vertexCount` ids, from the cache or from
+    // `compute(out)`. The result lives as long as the cache, or in `scratch`
+    // when the budget is spent.
+    template <typename Compute>
+    const std::vector<CourseId>& get(size_t vertexCount, CourseId v, std::vector<CourseId>& scratch,
+                                     Compute&& compute) const {
+        std::call_once(slotsOnce_, [&] {
+            slots_ = std::make_unique<std::atomic<const std::vector<CourseId>*>[]>(vertexCount);
+            for (size_t i = 0; i < vertexCount; ++i) slots_[i].store(nullptr, std::memory_order_relaxed);
+            size_ = vertexCount;
+        });
+        std::atomic<const std::vector<CourseId>*>& slot = slots_[v];
+        if (const std::vector<CourseId>* hit = slot.load(std::memory_order_acquire)) return *hit;
+
+        scratch.clear();
+        compute(scratch);
+        const size_t cost = scratch.size() + 1;
+        if (used_.fetch_add(cost, std::memory_order_relaxed) + cost > kDefaultBudget) {
+            used_.fetch_sub(cost, std::memory_order_relaxed);
+            return scratch;
+        }
+        auto fresh = std::make_unique<const std::vector<CourseId>>(scratch);
+        const std::vector<CourseId>* expected = nullptr;
+        if (slot.compare_exchange_strong(expected, fresh.get(), std::memory_order_acq_rel)) return *fresh.release();
+        used_.fetch_sub(cost, std::memory_order_relaxed);
+        return *expected;
+    }
+
+private:
+    mutable std::once_flag slotsOnce_;
+    mutable std::unique_ptr<std::atomic<const std::vector<CourseId>*>[]> slots_;
+    mutable size_t size_{0};
+    mutable std::atomic<size_t> used_{0};
+};
+
+// ---------- Catalog validation ----------
+//
+// Per-id flags and two counts. A full load finds them in one linear pass:
+// Tarjan's strongly connected components over the prereq graph finds cycles,
+// and a scan of the edges finds prereqs that name courses missing from the
+// file. A catalog built as an edit of another starts from the other's flags
+// and rechecks only what its edits can reach: missing prereqs of the edited
+// courses and of the dependents of courses that appeared or disappeared, and
+// cycles among the courses on a prereq path between edited ones, in the old
+// graph or the new.
+
+struct CatalogDiagnostics {
+    enum Flag : uint8_t {
+        kDefined = 1,          // the id is a course in the file
+        kMissingPrereq = 2,    // at least one prereq is not in the file
+        kInCycle = 4,          // on a prereq cycle (component of size > 1 or self-edge)
+    };
+
+    CowTable<uint8_t> flags; // per id
+    size_t missingRefs{0};   // prereq edges to ids not in the file
+    size_t cyclicCourses{0};
+
+    bool has(CourseId id, Flag f) const { return (flags[id] & f) != 0; }
+
+    void build(Arena& arena, const PrereqGraph& g) {
+        const size_t n = g.vertexCount();
+        flags.resize(n, arena);
+        missingRefs = 0;
+        cyclicCourses = 0;
+
+        std::vector<CourseId> all(n);
+        for (size_t v = 0; v < n; ++v) {
+            all[v] = static_cast<CourseId>(v);
+            if (!g.course(all[v])) continue;
+            const size_t missing = missingEdges(g, all[v]);
+            flags.mutableAt(v, arena) = kDefined | (missing ? kMissingPrereq : 0);
+            missingRefs += missing;
+        }
+        g.components(all, [&](const std::vector<CourseId>& members, bool cyclic) {
+            if (cyclic) markCycle(arena, g, members);
+        });
+    }
+
+    // The diagnostics of `g`, which is `oldGraph` (diagnosed by `base`) with
+    // `edits` applied.
+    void edit(Arena& arena, const CatalogDiagnostics& base, const PrereqGraph& oldGraph, const PrereqGraph& g,
+              const std::vector<CourseEdit>& edits) {
+        flags.shareFrom(base.flags);
+        flags.resize(g.vertexCount(), arena);
+        missingRefs = base.missingRefs;
+        cyclicCourses = base.cyclicCourses;
+
+        // Courses whose missing prereqs may differ, and courses whose edges did.
+        std::vector<CourseId> recheck, moved;
+        for (const CourseEdit& e : edits) {
+            const CourseId id = (e.after ? e.after : e.before)->id;
+            recheck.push_back(id);
+            if (!e.before || !e.after) {
+                for (CourseId d : g.dependents(id)) recheck.push_back(d);
+                moved.push_back(id);
+            } else if (!std::equal(e.before->prereqs.begin(), e.before->prereqs.end(), e.after->prereqs.begin(),
+                                   e.after->prereqs.end())) {
+                moved.push_back(id);
+            }
+        }
+        std::sort(recheck.begin(), recheck.end());
+        recheck.erase(std::unique(recheck.begin(), recheck.end()), recheck.end());
+        for (CourseId v : recheck) {
+            if (v < oldGraph.vertexCount() && oldGraph.course(v)) missingRefs -= missingEdges(oldGraph, v);
+            const size_t missing = g.course(v) ? missingEdges(g, v) : 0;
+            missingRefs += missing;
+            uint8_t& f = flags.mutableAt(v, arena);
+            f = static_cast<uint8_t>((f & kInCycle) | (g.course(v) ? kDefined : 0) | (missing ? kMissingPrereq : 0));
+        }
+
+        // A cycle that changed had a moved course on it, before or after.
+        std::vector<CourseId> region;
+        oldGraph.between(moved, region);
+        g.between(moved, region);
+        std::sort(region.begin(), region.end());
+        region.erase(std::unique(region.begin(), region.end()), region.end());
+        for (CourseId v : region) {
+            if (!has(v, kInCycle)) continue;
+            flags.mutableAt(v, arena) &= static_cast<uint8_t>(~kInCycle);
+            --cyclicCourses;
+        }
+        g.components(region, [&](const std::vector<CourseId>& members, bool cyclic) {
+            if (cyclic) markCycle(arena, g, members);
+        });
+    }
+
+private:
+    static size_t missingEdges(const PrereqGraph& g, CourseId v) {
+        size_t missing = 0;
+        for (CourseId p : g.prereqs(v)) missing += g.course(p) ? 0 : 1;
+        return missing;
+    }
+
+    void markCycle(Arena& arena, const PrereqGraph& g, const std::vector<CourseId>& members) {
+        for (CourseId m : members) {
+            if (!g.course(m)) continue;
+            flags.mutableAt(m, arena) |= kInCycle;
+            ++cyclicCourses;
+        }
+    }
+};
+
+// ---------- Title search ----------
+//
+// Inverted index from case-folded title words to the courses containing them.
+// Postings are course ranks in sorted-number order, so a decoded list is
+// already in display order. Each list is delta-encoded as LEB128 varints in
+// one shared byte array. The term dictionary is sorted, so a prefix query is
+// a binary search followed by a scan over adjacent terms.
+
+class TitleIndex {
+public:
+    // `sorted` is every loaded course in ascending number order; the index
+    // keeps the pointers to resolve results.
+    void build(std::vector<const Course*> sorted) {
+        courses_ = std::move(sorted);
+        terms_.clear();
+        termText_.clear();
+        postings_.clear();
+
+        std::unordered_map<std::string, std::vector<uint32_t>> lists;
+        std::string word;
+        for (uint32_t rank = 0; rank < courses_.size(); ++rank) {
+            forEachWord(courses_[rank]->title, word, [&](const std::string& w) {
+                std::vector<uint32_t>& list = lists[w];
+                if (list.empty() || list.back() != rank) list.push_back(rank); // once per title
+            });
+        }
+
+        std::vector<const std::pair<const std::string, std::vector<uint32_t>>*> order;
+        order.reserve(lists.size());
+        for (const auto& kv : lists) order.push_back(&kv);
+        std::sort(order.begin(), order.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+        terms_.reserve(order.size());
+        for (const auto* kv : order) {
+            Term t;
+            t.textOffset = static_cast<uint32_t>(termText_.size());
+            t.textLength = static_cast<uint32_t>(kv->first.size());
+            t.postingsOffset = postings_.size();
+            t.count = static_cast<uint32_t>(kv->second.size());
+            termText_.append(kv->first);
+            uint32_t prev = 0;
+            for (uint32_t rank : kv->second) {
+                putVarint(rank - prev);
+                prev = rank;
+            }
+            terms_.push_back(t);
+        }
+    }
+
+    // Courses whose titles contain every query word, in course-number order.
+    // A word ending in '*' matches any title word starting with it.
+    void search(std::string_view query, std::vector<const Course*>& out) const {
+        out.clear();
+        std::vector<std::vector<uint32_t>> lists;
+        bool any = false, emptyTerm = false;
+        std::string word;
+        // Words are split exactly as titles are, except that '*' marks a prefix.
+        size_t pos = 0;
+        while (pos <= query.size()) {
+            size_t end = query.find_first_of(" \t,", pos);
+            if (end == std::string_view::npos) end = query.size();
+            std::string_view token = query.substr(pos, end - pos);
+            pos = end + 1;
+            bool prefix = !token.empty() && token.back() == '*';
+            if (prefix) token.remove_suffix(1);
+            forEachWord(token, word, [&](const std::string& w) {
+                any = true;
+                lists.emplace_back();
+                if (prefix) {
+                    collectPrefix(w, lists.back());
+                } else if (const Term* t = findTerm(w)) {
+                    decode(*t, lists.back());
+                }
+                if (lists.back().empty()) emptyTerm = true;
+            });
+        }
+        if (!any || emptyTerm) return;
+
+        // Intersect shortest-first so the running result only shrinks.
+        std::sort(lists.begin(), lists.end(), [](const auto& a, const auto& b) { return a.size() < b.size(); });
+        std::vector<uint32_t> result = std::move(lists[0]), next;
+        for (size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+            next.clear();
+            std::set_intersection(result.begin(), result.end(), lists[i].begin(), lists[i].end(),
+                                  std::back_inserter(next));
+            result.swap(next);
+        }
+        out.reserve(result.size());
+        for (uint32_t rank : result) out.push_back(courses_[rank]);
+    }
+
+    size_t termCount() const { return terms_.size(); }
+    size_t postingBytes() const { return postings_.size(); }
+
+private:
+    struct Term {
+        uint32_t textOffset;
+        uint32_t textLength;
+        size_t postingsOffset;
+        uint32_t count;
+    };
+
+    std::vector<const Course*> courses_; // by rank
+    std::vector<Term> terms_;            // sorted by text
+    std::string termText_;
+    std::vector<uint8_t> postings_;
+
+    // Words are maximal runs of ASCII letters/digits or non-ASCII bytes (so
+    // UTF-8 letters stay inside words), with ASCII folded to lowercase.
+    template <typename Fn>
+    static void forEachWord(std::string_view text, std::string& word, Fn&& fn) {
+        word.clear();
+        for (size_t i = 0; i <= text.size(); ++i) {
+            unsigned char u = i < text.size() ? static_cast<unsigned char>(text[i]) : ' ';
+            if (u >= 0x80 || std::isalnum(u)) {
+                word.push_back(static_cast<char>(u < 0x80 ? std::tolower(u) : u));
+            } else if (!word.empty()) {
+                fn(word);
+                word.clear();
+            }
+        }
+    }
+
+    std::string_view text(const Term& t) const { return {termText_.data() + t.textOffset, t.textLength}; }
+
+    const Term* lowerTerm(std::string_view w) const {
+        auto it = std::lower_bound(terms_.begin(), terms_.end(), w,
+                                   [&](const Term& t, std::string_view key) { return text(t) < key; });
+        return it == terms_.end() ? nullptr : &*it;
+    }
+
+    const Term* findTerm(std::string_view w) const {
+        const Term* t = lowerTerm(w);
+        return (t && text(*t) == w) ? t : nullptr;
+    }
+
+    void collectPrefix(std::string_view w, std::vector<uint32_t>& out) const {
+        const Term* t = lowerTerm(w);
+        if (!t) return;
+        size_t lists = 0;
+        for (const Term* end = terms_.data() + terms_.size(); t != end && text(*t).substr(0, w.size()) == w; ++t) {
+            decode(*t, out);
+            ++lists;
+        }
+        if (lists > 1) {
+            std::sort(out.begin(), out.end());
+            out.erase(std::unique(out.begin(), out.end()), out.end());
+        }
+    }
+
+    void decode(const Term& t, std::vector<uint32_t>& out) const {
+        const uint8_t* p = postings_.data() + t.postingsOffset;
+        uint32_t rank = 0;
+        for (uint32_t i = 0; i < t.count; ++i) {
+            uint32_t delta = 0;
+            for (int shift = 0;; shift += 7) {
+                uint8_t b = *p++;
+                delta |= static_cast<uint32_t>(b & 0x7F) << shift;
+                if (!(b & 0x80)) break;
+            }
+            rank += delta;
+            out.push_back(rank);
+        }
+    }
+
+    void putVarint(uint32_t v) {
+        while (v >= 0x80) {
+            postings_.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        postings_.push_back(static_cast<uint8_t>(v));
+    }
+};
+
+// ---------- Course number suggestions ----------
+//
+// Deletion-neighbourhood index for "did you mean" lookups. Every loaded course
+// number is indexed under itself and under each string made by deleting one of
+// its characters. Two numbers within one edit always share such a variant, so
+// probing the query's own zero-, one- and two-deletion variants finds the
+// typical typos (one wrong, missing, extra or swapped character, or two extra)
+// with a few dozen lookups. Candidates are then ranked by exact edit distance.
+// Variant strings are never stored: entries are 32-bit hashes packed next to
+// the course's rank, so a collision can only add a candidate that the
+// distance check rejects.
+
+class SuggestionIndex {
+public:
+    void build(const std::vector<const Course*>& sorted) {
+        words_.clear();
+        entries_.clear();
+        words_.reserve(sorted.size());
+        for (const Course* c : sorted) words_.push_back(c->number);
+
+        for (uint32_t rank = 0; rank < words_.size(); ++rank) {
+            std::string_view w = words_[rank];
+            add(hashWithout(w, kKeep, kKeep), rank);
+            for (size_t i = 0; i < w.size(); ++i) {
+                if (i > 0 && w[i] == w[i - 1]) continue; // same variant as deleting w[i - 1]
+                add(hashWithout(w, i, kKeep), rank);
+            }
+        }
+        std::sort(entries_.begin(), entries_.end());
+        entries_.erase(std::unique(entries_.begin(), entries_.end()), entries_.end());
+    }
+
+    // Up to `k` numbers within `maxDistance` edits (insert, delete, substitute or
+    // swap adjacent characters) of `query`, nearest first, ties in number order.
+    void nearest(std::string_view query, size_t k, uint32_t maxDistance, std::vector<std::string_view>& out) const {
+        out.clear();
+        if (words_.empty() || k == 0 || query.empty()) return;
+
+        std::vector<uint32_t> candidates;
+        probe(hashWithout(query, kKeep, kKeep), candidates);
+        for (size_t i = 0; i < query.size(); ++i) {
+            probe(hashWithout(query, i, kKeep), candidates);
+            if (maxDistance < 2) continue;
+            for (size_t j = i + 1; j < query.size(); ++j) probe(hashWithout(query, i, j), candidates);
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        std::vector<std::pair<uint32_t, uint32_t>> ranked; // (distance, rank)
+        for (uint32_t rank : candidates) {
+            uint32_t d = distance(query, words_[rank], maxDistance + 1);
+            if (d <= maxDistance && d > 0) ranked.emplace_back(d, rank);
+        }
+        std::sort(ranked.begin(), ranked.end());
+        for (size_t i = 0; i < ranked.size() && i < k; ++i) out.push_back(words_[ranked[i].second]);
+    }
+
+private:
+    static constexpr size_t kKeep = SIZE_MAX; // "delete nothing" position
+
+    std::vector<std::string_view> words_; // course numbers by rank (sorted order)
+    std::vector<uint64_t> entries_;       // (variant hash << 32) | rank, sorted
+
+    void add(uint32_t hash, uint32_t rank) { entries_.push_back((uint64_t{hash} << 32) | rank); }
+
+    void probe(uint32_t hash, std::vector<uint32_t>& out) const {
+        const uint64_t lo = uint64_t{hash} << 32;
+        for (auto it = std::lower_bound(entries_.begin(), entries_.end(), lo);
+             it != entries_.end() && (*it >> 32) == hash; ++it) {
+            out.push_back(static_cast<uint32_t>(*it));
+        }
+    }
+
+    // FNV-1a of `s` with the characters at positions a and b left out.
+    static uint32_t hashWithout(std::string_view s, size_t a, size_t b) {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < s.size(); ++i) {
+            if (i == a || i == b) continue;
+            h = (h ^ static_cast<unsigned char>(s[i])) * 16777619u;
+        }
+        return h;
+    }
+
+    // Optimal string alignment distance (Levenshtein plus adjacent swaps),
+    // returning `cutoff` as soon as the answer is known to reach it.
+    static uint32_t distance(std::string_view a, std::string_view b, uint32_t cutoff) {
+        if (a.size() < b.size()) std::swap(a, b);
+        if (a.size() - b.size() >= cutoff) return cutoff;
+        constexpr size_t kInline = 32;
+        uint32_t rowsInline[3 * (kInline + 1)];
+        std::vector<uint32_t> rowsHeap;
+        uint32_t* rows = rowsInline;
+        if (b.size() > kInline) {
+            rowsHeap.resize(3 * (b.size() + 1));
+            rows = rowsHeap.data();
+        }
+        uint32_t* prev2 = rows;
+        uint32_t* prev = prev2 + b.size() + 1;
+        uint32_t* cur = prev + b.size() + 1;
+
+        for (size_t j = 0; j <= b.size(); ++j) prev[j] = static_cast<uint32_t>(j);
+        for (size_t i = 1; i <= a.size(); ++i) {
+            cur[0] = static_cast<uint32_t>(i);
+            uint32_t rowMin = cur[0];
+            for (size_t j = 1; j <= b.size(); ++j) {
+                uint32_t d = std::min({prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + (a[i - 1] != b[j - 1])});
+                if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]) d = std::min(d, prev2[j - 2] + 1);
+                cur[j] = d;
+                rowMin = std::min(rowMin, d);
+            }
+            if (rowMin >= cutoff) return cutoff;
+            uint32_t* spare = prev2;
+            prev2 = prev;
+            prev = cur;
+            cur = spare;
+        }
+        return std::min(prev[b.size()], cutoff);
+    }
+};
+
+// ---------- Semester scheduling ----------
+//
+// Layers the courses a student still needs into terms with Kahn's algorithm:
+// a course becomes available the term after its last needed prereq, and each
+// term takes at most maxPerTerm available courses, longest remaining chain
+// first, then by course number. Everything works on ids with epoch-stamped
+// scratch arrays sized to the catalog, so a plan costs time proportional to
+// the courses involved.
+
+struct TermPlan {
+    std::vector<std::vector<CourseId>> terms;
+    std::vector<CourseId> unschedulable; // missing from the file, cyclic, or blocked by those
+};
+
+class TermScheduler {
+public:
+    void plan(const PrereqGraph& g, const CatalogDiagnostics& d, const std::vector<CourseId>& targets,
+              const std::vector<CourseId>& completed, size_t maxPerTerm, TermPlan& out) const {
+        out.terms.clear();
+        out.unschedulable.clear();
+        if (maxPerTerm == 0) maxPerTerm = 1;
+
+        Scratch& s = threadScratch();
+        const size_t n = g.vertexCount();
+        if (s.doneStamp.size() != n) {
+            s.doneStamp.assign(n, 0);
+            s.needStamp.assign(n, 0);
+            s.local.assign(n, 0);
+            s.epoch = 0;
+        }
+        if (++s.epoch == 0) {
+            std::fill(s.doneStamp.begin(), s.doneStamp.end(), 0);
+            std::fill(s.needStamp.begin(), s.needStamp.end(), 0);
+            s.epoch = 1;
+        }
+        const uint32_t mark = s.epoch;
+
+        // Completing a course means its prereqs were completed too, so mark the
+        // whole prereq closure of every completed course as done.
+        s.needed.clear();
+        for (CourseId c : completed) {
+            if (s.doneStamp[c] == mark) continue;
+            s.doneStamp[c] = mark;
+            s.needed.push_back(c);
+            while (!s.needed.empty()) {
+                CourseId v = s.needed.back();
+                s.needed.pop_back();
+                for (CourseId p : g.prereqs(v)) {
+                    if (s.doneStamp[p] == mark) continue;
+                    s.doneStamp[p] = mark;
+                    s.needed.push_back(p);
+                }
+            }
+        }
+
+        // Needed courses: the targets plus everything they transitively require,
+        // stopping at done courses.
+        auto need = [&](CourseId v) {
+            if (s.doneStamp[v] == mark || s.needStamp[v] == mark) return;
+            s.needStamp[v] = mark;
+            s.local[v] = static_cast<uint32_t>(s.needed.size());
+            s.needed.push_back(v);
+        };
+        for (CourseId t : targets) need(t);
+        for (size_t i = 0; i < s.needed.size(); ++i) {
+            for (CourseId p : g.prereqs(s.needed[i])) need(p);
+        }
+
+        // Local dependents lists (CSR) and pending-prereq counts.
+        const size_t m = s.needed.size();
+        s.pending.assign(m, 0);
+        s.revOffsets.assign(m + 1, 0);
+        for (size_t i = 0; i < m; ++i) {
+            for (CourseId p : g.prereqs(s.needed[i])) {
+                if (s.needStamp[p] != mark) continue;
+                ++s.pending[i];
+                ++s.revOffsets[s.local[p] + 1];
+            }
+        }
+        for (size_t i = 0; i < m; ++i) s.revOffsets[i + 1] += s.revOffsets[i];
+        s.revEdges.resize(s.revOffsets[m]);
+        s.fill.assign(s.revOffsets.begin(), s.revOffsets.end() - 1);
+        for (size_t i = 0; i < m; ++i) {
+            for (CourseId p : g.prereqs(s.needed[i])) {
+                if (s.needStamp[p] == mark) s.revEdges[s.fill[s.local[p]]++] = static_cast<uint32_t>(i);
+            }
+        }
+
+        // Priority: length of the longest chain of needed courses that depend on
+        // this one. Peel courses whose needed dependents are all done (Kahn's
+        // algorithm on the reversed edges), so each is final when reached;
+        // courses on a cycle are never peeled and keep 1, as they cannot be
+        // scheduled anyway. `order` is the peeling queue.
+        s.chain.assign(m, 1);
+        s.waiting.resize(m);
+        s.order.clear();
+        for (size_t i = 0; i < m; ++i) {
+            s.waiting[i] = s.revOffsets[i + 1] - s.revOffsets[i];
+            if (s.waiting[i] == 0) s.order.push_back(static_cast<uint32_t>(i));
+        }
+        for (size_t q = 0; q < s.order.size(); ++q) {
+            const uint32_t i = s.order[q];
+            for (CourseId p : g.prereqs(s.needed[i])) {
+                if (s.needStamp[p] != mark) continue;
+                const uint32_t j = s.local[p];
+                s.chain[j] = std::max(s.chain[j], s.chain[i] + 1);
+                if (--s.waiting[j] == 0) s.order.push_back(j);
+            }
+        }
+
+        // Ties go to the lower course number.
+        auto lower = [&](uint32_t a, uint32_t b) {
+            if (s.chain[a] != s.chain[b]) return s.chain[a] < s.chain[b];
+            return internedLess(*g.course(s.needed[b]), *g.course(s.needed[a]));
+        };
+        std::priority_queue<uint32_t, std::vector<uint32_t>, decltype(lower)> ready(lower);
+        for (size_t i = 0; i < m; ++i) {
+            if (s.pending[i] == 0 && d.has(s.needed[i], CatalogDiagnostics::kDefined)) ready.push(static_cast<uint32_t>(i));
+        }
+
+        size_t scheduled = 0;
+        std::vector<uint32_t> term;
+        while (!ready.empty()) {
+            term.clear();
+            while (!ready.empty() && term.size() < maxPerTerm) {
+                term.push_back(ready.top());
+                ready.pop();
+            }
+            out.terms.emplace_back();
+            for (uint32_t i : term) out.terms.back().push_back(s.needed[i]);
+            scheduled += term.size();
+            // Dependents unlock only once the whole term is complete.
+            for (uint32_t i : term) {
+                for (uint32_t k = s.revOffsets[i]; k < s.revOffsets[i + 1]; ++k) {
+                    uint32_t dep = s.revEdges[k];
+                    if (--s.pending[dep] == 0 && d.has(s.needed[dep], CatalogDiagnostics::kDefined)) ready.push(dep);
+                }
+            }
+        }
+
+        if (scheduled < m) {
+            for (size_t i = 0; i < m; ++i) {
+                if (s.pending[i] != 0 || !d.has(s.needed[i], CatalogDiagnostics::kDefined)) {
+                    out.unschedulable.push_back(s.needed[i]);
+                }
+            }
+        }
+    }
+
+private:
+    // Per-thread scratch, so one scheduler can plan for several threads at once.
+    struct Scratch {
+        std::vector<uint32_t> doneStamp, needStamp, local;
+        uint32_t epoch{0};
+        std::vector<CourseId> needed;
+        std::vector<uint32_t> pending, revOffsets, revEdges, fill, waiting, order, chain;
+    };
+
+    static Scratch& threadScratch() {
+        thread_local Scratch scratch;
+        return scratch;
+    }
+};
+
+// ---------- Binary catalog snapshot ----------
+//
+// Layout (native byte order, every section 8-byte aligned):
+//   SnapshotHeader
+//   source CSV path bytes
+//   SnapshotString[symbolCount]    id -> course number
+//   SnapshotCourse[courseCount]    loaded courses, ascending by number
+//   CourseId[prereqCount]          prereq edges, referenced by SnapshotCourse
+//   string pool                    numbers and titles
+// A loaded snapshot is used in place: course strings and prereq spans point
+// straight into the mapping, so only the course store itself is allocated.
+
+constexpr char kSnapshotMagic[8] = {'A', 'B', 'C', 'U', 'S', 'N', 'A', 'P'};
+constexpr uint32_t kSnapshotVersion = 1;
+constexpr uint32_t kSnapshotByteOrder = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t sourceSize;
+    int64_t sourceMtimeNs;
+    uint32_t sourcePathLength;
+    uint32_t symbolCount;
+    uint32_t courseCount;
+    uint32_t reserved;
+    uint64_t prereqCount;
+    uint64_t stringBytes;
+};
+
+struct SnapshotString {
+    uint64_t offset; // into the string pool
+    uint64_t length;
+};
+
+struct SnapshotCourse {
+    CourseId id;
+    uint32_t prereqCount;
+    uint64_t firstPrereq;
+    SnapshotString title;
+};
+
+static constexpr uint64_t alignUp8(uint64_t n) { return (n + 7) & ~uint64_t{7}; }
+
+// ---------- Rendered response cache ----------
+//
+// Bounded LRU of fully rendered course responses. A few gateway courses get
+// most lookups, so their answers are kept ready to write instead of being
+// re-resolved and re-formatted prereq by prereq. Entries are keyed by course id
+// and response kind and stamped with the catalog generation that produced
+// them; an entry from an older catalog never matches. The cache is split into
+// shards by id, each with its own lock, recency list and counters, so readers
+// on different cores rarely contend.
+
+class ResponseCache {
+public:
+    enum Kind : uint32_t {
+        kInfoText = 0,   // printCourseInfo
+        kCourseJson = 1, // writeCourseJson
+    };
+
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        size_t entries{0};
+        size_t capacity{0};
+    };
+
+    static constexpr size_t kDefaultCapacity = 1024;
+
+    ResponseCache() { setCapacity(kDefaultCapacity); }
+
+    // Total entries across all shards; 0 disables caching. Drops every entry and
+    // resets the counters, so call it before queries start.
+    void setCapacity(size_t entries) {
+        capacity_ = entries;
+        for (size_t i = 0; i < kShards; ++i) {
+            Shard& s = shards_[i];
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.lru.clear();
+            s.index.clear();
+            s.capacity = entries / kShards + (i < entries % kShards ? 1 : 0);
+            s.hits = s.misses = 0;
+        }
+    }
+
+    // Copies the cached response into `out` and marks it most recently used.
+    bool find(uint64_t generation, CourseId id, Kind kind, std::string& out) {
+        Shard& s = shardFor(id);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto it = s.index.find(keyOf(id, kind));
+        if (it == s.index.end() || it->second->generation != generation) {
+            ++s.misses;
+            return false;
+        }
+        s.lru.splice(s.lru.begin(), s.lru, it->second);
+        out = it->second->response;
+        ++s.hits;
+        return true;
+    }
+
+    void insert(uint64_t generation, CourseId id, Kind kind, const std::string& response) {
+        Shard& s = shardFor(id);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.capacity == 0) return;
+        const uint64_t key = keyOf(id, kind);
+        auto it = s.index.find(key);
+        if (it != s.index.end()) {
+            if (it->second->generation > generation) return; // a reader of an older catalog
+            it->second->generation = generation;
+            it->second->response = response;
+            s.lru.splice(s.lru.begin(), s.lru, it->second);
+            return;
+        }
+        if (s.lru.size() >= s.capacity) {
+            s.index.erase(s.lru.back().key);
+            s.lru.pop_back();
+        }
+        s.lru.push_front({key, generation, response});
+        s.index.emplace(key, s.lru.begin());
+    }
+
+    // Frees every entry; counters keep running.
+    void clear() {
+        for (Shard& s : shards_) {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.lru.clear();
+            s.index.clear();
+        }
+    }
+
+    Stats stats() const {
+        Stats total;
+        total.capacity = capacity_;
+        for (const Shard& s : shards_) {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            total.hits += s.hits;
+            total.misses += s.misses;
+            total.entries += s.lru.size();
+        }
+        return total;
+    }
+
+private:
+    static constexpr size_t kShards = 16;
+
+    struct Entry {
+        uint64_t key;
+        uint64_t generation;
+        std::string response;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> lru; // most recently used first
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+        size_t capacity{0};
+        uint64_t hits{0};
+        uint64_t misses{0};
+    };
+
+    Shard shards_[kShards];
+    size_t capacity_{0};
+
+    static uint64_t keyOf(CourseId id, Kind kind) { return (uint64_t{id} << 1) | kind; }
+    Shard& shardFor(CourseId id) { return shards_[id % kShards]; }
+};
+
+// ---------- Runtime statistics ----------
+//
+// Per-phase load timers and lookup latency histograms, compiled in unless
+// ADVISING_NO_STATS is defined. Everything is a relaxed atomic counter, so
+// recording costs two clock reads and an increment or two; with the macro
+// defined the timers are empty types and every call compiles away. Catalog
+// gauges (course count, store height, arena bytes) cost nothing until read.
+
+#ifndef ADVISING_NO_STATS
+#define ADVISING_STATS 1
+#endif
+
+#ifdef ADVISING_STATS
+using StatsTime = std::chrono::steady_clock::time_point;
+static inline StatsTime statsNow() { return std::chrono::steady_clock::now(); }
+static inline uint64_t nsSince(StatsTime t) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(statsNow() - t).count());
+}
+#else
+struct StatsTime {};
+static inline StatsTime statsNow() { return {}; }
+#endif
+
+// Log2-bucketed latency histogram: bucket i counts samples of at most
+// 128 << i nanoseconds, the last one everything slower (~1.07 s and up).
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 24;
+
+    // Records `count` operations that took `ns` in all, each at their mean.
+    void record(uint64_t ns, uint64_t count = 1) {
+        if (count == 0) return;
+        const uint64_t each = ns / count;
+        size_t b = 0;
+        for (uint64_t bound = kFirstBoundNs; b < kBuckets && each > bound; bound <<= 1) ++b;
+        counts_[b].fetch_add(count, std::memory_order_relaxed);
+        sumNs_.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    // Appends the histogram in Prometheus text format, in seconds.
+    void appendPrometheus(std::string& out, const char* name, const char* help) const {
+        out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+        out.append("# TYPE ").append(name).append(" histogram\n");
+        uint64_t cumulative = 0;
+        char num[32];
+        for (size_t b = 0; b <= kBuckets; ++b) {
+            cumulative += counts_[b].load(std::memory_order_relaxed);
+            if (b < kBuckets) {
+                std::snprintf(num, sizeof num, "%.9g", static_cast<double>(kFirstBoundNs << b) / 1e9);
+            } else {
+                std::snprintf(num, sizeof num, "+Inf");
+            }
+            out.append(name).append("_bucket{le=\"").append(num).append("\"} ");
+            out.append(std::to_string(cumulative)).append("\n");
+        }
+        std::snprintf(num, sizeof num, "%.9g", static_cast<double>(sumNs_.load(std::memory_order_relaxed)) / 1e9);
+        out.append(name).append("_sum ").append(num).append("\n");
+        out.append(name).append("_count ").append(std::to_string(cumulative)).append("\n");
+    }
+
+private:
+    static constexpr uint64_t kFirstBoundNs = 128;
+
+    std::atomic<uint64_t> counts_[kBuckets + 1] = {};
+    std::atomic<uint64_t> sumNs_{0};
+};
+
+class PlannerStats {
+public:
+    enum Phase : size_t {
+        kMap,    // open and map the file (or snapshot)
+        kParse,  // split lines into fields and uppercase course numbers
+        kIntern, // intern numbers, resolve prereq ids, report bad lines
+        kSort,   // sort rows and drop duplicates
+        kBuild,  // copy into the catalog arena and build the store
+        kIndex,  // id table, prereq graph, validation
+        kPhaseCount,
+    };
+    static constexpr const char* kPhaseNames[kPhaseCount] = {"map", "parse", "intern", "sort", "build", "index"};
+
+    // Records the time since `t` against `p` and returns the current time, so
+    // consecutive phases can be chained.
+    StatsTime phase(Phase p, StatsTime t) {
+#ifdef ADVISING_STATS
+        const uint64_t ns = nsSince(t);
+        phaseNs_[p].fetch_add(ns, std::memory_order_relaxed);
+        lastPhaseNs_[p].store(ns, std::memory_order_relaxed);
+#else
+        (void)p;
+        (void)t;
+#endif
+        return statsNow();
+    }
+
+    void loaded() {
+#ifdef ADVISING_STATS
+        loads_.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    // Records the time since it was created into a histogram, as `count`
+    // operations when it times a batch.
+    class Scope {
+    public:
+#ifdef ADVISING_STATS
+        explicit Scope(LatencyHistogram& h, uint64_t count = 1) : h_(h), count_(count), start_(statsNow()) {}
+        ~Scope() { h_.record(nsSince(start_), count_); }
+
+    private:
+        LatencyHistogram& h_;
+        uint64_t count_;
+        StatsTime start_;
+#else
+        explicit Scope(LatencyHistogram&, uint64_t = 1) {}
+#endif
+    };
+
+    LatencyHistogram find;       // CourseStore::find and findMany (per key) on query paths
+    LatencyHistogram courseInfo; // printCourseInfo end to end
+
+    void appendPrometheus(std::string& out) const {
+#ifdef ADVISING_STATS
+        char num[32];
+        out.append("# HELP advising_loads_total Catalogs loaded from CSV or snapshot.\n");
+        out.append("# TYPE advising_loads_total counter\n");
+        out.append("advising_loads_total ").append(std::to_string(loads_.load(std::memory_order_relaxed))).append("\n");
+        out.append("# HELP advising_load_phase_seconds_total Time spent in each load phase across all loads.\n");
+        out.append("# TYPE advising_load_phase_seconds_total counter\n");
+        for (size_t p = 0; p < kPhaseCount; ++p) {
+            std::snprintf(num, sizeof num, "%.9g", static_cast<double>(phaseNs_[p].load()) / 1e9);
+            out.append("advising_load_phase_seconds_total{phase=\"").append(kPhaseNames[p]).append("\"} ");
+            out.append(num).append("\n");
+        }
+        out.append("# HELP advising_last_load_phase_seconds Time spent in each phase of the most recent load.\n");
+        out.append("# TYPE advising_last_load_phase_seconds gauge\n");
+        for (size_t p = 0; p < kPhaseCount; ++p) {
+            std::snprintf(num, sizeof num, "%.9g", static_cast<double>(lastPhaseNs_[p].load()) / 1e9);
+            out.append("advising_last_load_phase_seconds{phase=\"").append(kPhaseNames[p]).append("\"} ");
+            out.append(num).append("\n");
+        }
+        find.appendPrometheus(out, "advising_find_latency_seconds", "Course lookups in the course store.");
+        courseInfo.appendPrometheus(out, "advising_course_info_latency_seconds", "printCourseInfo calls, end to end.");
+#else
+        (void)out;
+#endif
+    }
+
+private:
+#ifdef ADVISING_STATS
+    std::atomic<uint64_t> loads_{0};
+    std::atomic<uint64_t> phaseNs_[kPhaseCount] = {};
+    std::atomic<uint64_t> lastPhaseNs_[kPhaseCount] = {};
+#endif
+};
+
+// ---------- Answer formatting ----------
+//
+// The text and JSON shapes of query answers. Each backend (the planner's
+// in-memory catalog, the paged catalog) finds the courses in its own way and
+// hands their fields to these, so the two answer alike.
+
+static constexpr std::string_view kListRule = "-----------------------------------------\n";
+static constexpr std::string_view kCourseListHeading = "ABCU Computer Science Course List (sorted)";
+
+// Opens a listing: a blank line, the heading, then a rule.
+static void appendListHeading(std::string& buf, std::string_view heading) {
+    buf.append("\n").append(heading).append("\n").append(kListRule);
+}
+
+// One "NUMBER, Title" line of a listing or lookup.
+static void appendListLine(std::string& buf, std::string_view number, std::string_view title) {
+    buf.append(number).append(", ").append(title).push_back('\n');
+}
+
+// Heading of a `prefix` (hi empty) or `range` listing.
+static std::string rangeHeading(std::string_view lo, std::string_view hi) {
+    std::string heading;
+    if (hi.empty()) {
+        heading.append("Courses starting with ").append(lo);
+    } else {
+        heading.append("Courses from ").append(lo).append(" to ").append(hi);
+    }
+    return heading;
+}
+
+// Closes a listing of `count` courses.
+static void appendListTotal(std::string& buf, size_t count) {
+    buf.append(kListRule).append("Total: ").append(std::to_string(count)).append(" course(s)\n\n");
+}
+
+// The "NUMBER: Title" line that opens a course's details.
+static void appendCourseHeading(std::string& buf, std::string_view number, std::string_view title) {
+    buf.append("\n").append(number).append(": ").append(title).push_back('\n');
+}
+
+// One "  - NUMBER: Title" line, or the number flagged when the file lacks it.
+static void appendPrereqLine(std::string& buf, std::string_view number, std::string_view title, bool defined) {
+    if (defined) {
+        buf.append("  - ").append(number).append(": ").append(title).push_back('\n');
+    } else {
+        buf.append("  - ").append(number).append(" (title not found in file)\n");
+    }
+}
+
+static void appendNotFound(std::string& buf, std::string_view number, const std::vector<std::string_view>& close) {
+    buf.append("Course \"").append(number).append("\" was not found. ");
+    buf.append("Be sure you typed the correct course number (e.g., CSCI200).\n");
+    if (close.empty()) return;
+    buf.append("Did you mean:");
+    for (size_t i = 0; i < close.size(); ++i) buf.append(i ? ", " : " ").append(close[i]);
+    buf.append("?\n");
+}
+
+// Finishes a JSON course object opened with its number (see
+// CoursePlanner::findForJson) as a miss.
+static void appendJsonMiss(std::string& buf, const std::vector<std::string_view>& close) {
+    buf.append(",\"error\":\"not found\",\"suggestions\":[");
+    for (size_t i = 0; i < close.size(); ++i) {
+        if (i) buf.push_back(',');
+        appendJsonString(buf, close[i]);
+    }
+    buf.append("]}\n");
+}
+
+// One {"number":...,"title":...} entry of a JSON prereq list; a null title
+// marks a prereq missing from the file.
+static void appendJsonPrereq(std::string& buf, std::string_view number, std::string_view title, bool defined) {
+    buf.append("{\"number\":");
+    appendJsonString(buf, number);
+    buf.append(",\"title\":");
+    if (defined) {
+        appendJsonString(buf, title);
+    } else {
+        buf.append("null");
+    }
+    buf.push_back('}');
+}
+
+// One NDJSON course line; `forEachPrereq(fn)` calls fn with each prereq number.
+template <typename Prereqs>
+static void appendCourseNdjson(std::string& buf, std::string_view number, std::string_view title,
+                               Prereqs&& forEachPrereq) {
+    buf.append("{\"number\":");
+    appendJsonString(buf, number);
+    buf.append(",\"title\":");
+    appendJsonString(buf, title);
+    buf.append(",\"prereqs\":[");
+    bool first = true;
+    forEachPrereq([&](std::string_view p) {
+        if (!first) buf.push_back(',');
+        first = false;
+        appendJsonString(buf, p);
+    });
+    buf.append("]}\n");
+}
+
+// Closes a lookup of `asked` numbers, `found` of which were in the catalog.
+static void appendLookupTotal(std::string& buf, size_t found, size_t asked) {
+    buf.append("Found ").append(std::to_string(found)).append(" of ");
+    buf.append(std::to_string(asked)).append(" course(s).\n\n");
+}
+
+static void appendLookupMissNdjson(std::string& buf, std::string_view number) {
+    buf.append("{\"number\":");
+    appendJsonString(buf, number);
+    buf.append(",\"error\":\"not found\"}\n");
+}
+
+// ---------- Published catalog ----------
+//
+// Everything one load produces. A catalog is built off to the side by a single
+// loader thread and never modified once the planner publishes it; readers take
+// a shared_ptr to the current catalog for the length of one query. Publishing a
+// replacement neither waits for readers nor frees what they still hold: the old
+// catalog goes away with its last reader, and its pool with the last catalog
+// built in it.
+
+struct Catalog {
+    Catalog(StoreKind storeKind, std::shared_ptr<CatalogPool> from)
+        : pool(std::move(from)), kind(storeKind), store(makeCourseStore(kind, pool->arena())) {}
+
+    std::shared_ptr<CatalogPool> pool; // declared first so it outlives its users
+    const StoreKind kind;
+    std::unique_ptr<CourseStore> store;
+    SymbolView symbols; // the pool's ids when the catalog was built
+    PrereqGraph graph;  // also the id -> course table
+    CatalogDiagnostics diagnostics;
+    std::string sourceFile;
+    FileStamp sourceStamp; // of the CSV the catalog was built from
+    std::string term;       // name when loaded as a term, else empty
+    uint64_t generation{0}; // assigned on publish; increases with every load
+
+    size_t sharedCourses{0};   // records still those of the catalog this was edited from
+    std::string editedFrom;    // that catalog's term name, if it had one
+    size_t ownBytes{0};        // what the build added to the pool, plus heap outside it
+    size_t standaloneBytes{0}; // about what a full build of the same courses takes
+
+    // Copies `sorted` into the pool as the catalog's course records and
+    // indexes them in the store.
+    void storeCourses(const std::vector<Course>& sorted) {
+        const Course* records = pool->arena().copyArray(sorted.data(), sorted.size());
+        std::vector<const Course*> order(sorted.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = records + i;
+        store->buildFromSorted(order);
+    }
+
+    // The graph and diagnostics, from the store's courses. Called once, after
+    // the store is built.
+    void buildIndexes() {
+        symbols = SymbolView(pool->symbols(), pool->symbols().size());
+        graph.build(pool->arena(), symbols.size(), sortedCourses());
+        diagnostics.build(pool->arena(), graph);
+    }
+
+    // Builds everything as `base` with `edits` applied, in base's pool;
+    // `sorted` lists the resulting courses in order. The store, the graph
+    // and the diagnostics start out sharing base's and change only what the
+    // edits reach. Base may be read meanwhile and need not outlive this one.
+    void buildEdit(const Catalog& base, const std::vector<const Course*>& sorted, const std::vector<CourseEdit>& edits) {
+        Arena& arena = pool->arena();
+        symbols = SymbolView(pool->symbols(), pool->symbols().size());
+        store = base.store->edited(arena, sorted, edits);
+        graph.edit(arena, base.graph, symbols.size(), edits);
+        diagnostics.edit(arena, base.diagnostics, base.graph, graph, edits);
+    }
+
+    // Heap bytes outside the pool.
+    size_t heapBytes() const { return store->heapBytes() + graph.heapBytes() + diagnostics.flags.heapBytes(); }
+
+    // Title search and "did you mean" indexes, each built by its first caller.
+    // Many catalogs never see a search or a miss (a term held only to be
+    // compared, a snapshot serving exact lookups), and neither index is cheap,
+    // so loads don't pay for them up front.
+    const TitleIndex& titles() const {
+        std::call_once(titlesOnce_, [this] { titles_.build(sortedCourses()); });
+        return titles_;
+    }
+    const SuggestionIndex& suggestions() const {
+        std::call_once(suggestionsOnce_, [this] { suggestions_.build(sortedCourses()); });
+        return suggestions_;
+    }
+
+    // Every course that must be taken before `v`, in a valid order to take
+    // them (PrereqGraph::closure), computed once per catalog.
+    const std::vector<CourseId>& prereqChain(CourseId v, std::vector<CourseId>& scratch) const {
+        return chains_.get(graph.vertexCount(), v, scratch, [&](std::vector<CourseId>& out) { graph.closure(v, out); });
+    }
+
+    // Every transitive dependent of `v`, in course-number order, computed once
+    // per catalog.
+    const std::vector<CourseId>& allDependents(CourseId v, std::vector<CourseId>& scratch) const {
+        return dependents_.get(graph.vertexCount(), v, scratch, [&](std::vector<CourseId>& out) {
+            graph.dependentClosure(v, out);
+            std::sort(out.begin(), out.end(),
+                      [&](CourseId a, CourseId b) { return internedLess(*graph.course(a), *graph.course(b)); });
+        });
+    }
+
+    // The Option 2 listing. It cannot change for the life of the catalog, so the
+    // first caller renders it into one buffer and everyone shares the result.
+    const std::string& courseList() const {
+        std::call_once(listOnce_, [this] {
+            size_t bytes = kCourseListHeading.size() + 2 * kListRule.size() + 48;
+            store->inOrder([&](const Course& c) { bytes += c.number.size() + c.title.size() + 3; });
+            list_.reserve(bytes);
+
+            appendListHeading(list_, kCourseListHeading);
+            store->inOrder([&](const Course& c) { appendListLine(list_, c.number, c.title); });
+            appendListTotal(list_, store->size());
+        });
+        return list_;
+    }
+
+private:
+    mutable std::once_flag listOnce_;
+    mutable std::string list_;
+    ClosureCache chains_;
+    ClosureCache dependents_;
+    mutable std::once_flag titlesOnce_;
+    mutable TitleIndex titles_;
+    mutable std::once_flag suggestionsOnce_;
+    mutable SuggestionIndex suggestions_;
+
+    std::vector<const Course*> sortedCourses() const {
+        std::vector<const Course*> sorted;
+        sorted.reserve(store->size());
+        store->inOrder([&](const Course& c) { sorted.push_back(&c); });
+        return sorted;
+    }
+};
+
+// ---------- Planner orchestrates loading, storage, and printing ----------
+//
+// Every query method is safe to call from any number of threads, including
+// while another thread reloads. Loads are serialized among themselves.
+
+class CoursePlanner {
+public:
+    // With `progress`, the load reports how far it got there and can be
+    // cancelled through it; the catalog queries see is untouched until the new
+    // one is complete.
+    bool loadFromFile(const std::string& filename, std::string& outError, LoadProgress* progress = nullptr) {
+        std::lock_guard<std::mutex> lock(loadMutex_);
+        return loadLocked(filename, outError, progress);
+    }
+
+    // Re-reads `filename` and reports what changed against the loaded catalog:
+    // courses added, courses whose title or prereqs differ, and courses absent
+    // from the file. Falls back to a plain load when nothing is loaded yet.
+    // When only a few courses changed, the new catalog is built as an edit of
+    // the loaded one (see parseCatalog) and the report says how many courses
+    // the two share. Either way it is complete before it replaces the old one,
+    // so concurrent queries see either catalog, never a mix. A term catalog is
+    // replaced by the same term.
+    bool reloadAndReport(const std::string& filename, std::string& outError) {
+        std::lock_guard<std::mutex> lock(loadMutex_);
+        std::shared_ptr<const Catalog> old = catalog(); // read under the lock so no load publishes in between
+        if (!old) return loadLocked(filename, outError);
+
+        LoadCounts counts;
+        std::shared_ptr<Catalog> next = parseCatalog(filename, counts, outError, old->term, old.get());
+        if (!next) return false;
+        publish(next);
+        if (!next->term.empty()) addTerm(next);
+
+        log() << "Reloaded \"" << filename << "\": " << counts.added << " added, " << counts.changed << " changed, "
+              << counts.removed << " removed";
+        if (counts.skipped) log() << " (" << counts.skipped << " line(s) skipped for format issues)";
+        if (next->sharedCourses) {
+            log() << "; " << next->sharedCourses << " course(s) shared with the previous catalog.\n";
+        } else {
+            log() << "; rebuilt in full.\n";
+        }
+        reportValidation(*next, log());
+        return true;
+    }
+
+    // Loads `filename` as the term `name` (replacing a term of that name) and
+    // makes it the catalog queries see. All terms live in one pool with one
+    // numbering of courses, and each is built as an edit of the term loaded
+    // before it when the two are close: a course that did not change keeps
+    // that term's record and tree node, and only the changed courses' entries
+    // are stored again. Titles and prereq lists are shared across all terms
+    // either way.
+    bool loadTerm(const std::string& name, const std::string& filename, std::string& outError) {
+        if (name.empty()) {
+            outError = "Error: term name cannot be empty.";
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(loadMutex_);
+        LoadCounts counts;
+        std::shared_ptr<Catalog> next = parseCatalog(filename, counts, outError, name, latestTerm_.get());
+        if (!next) return false;
+        publish(next);
+        addTerm(next);
+
+        log() << "Loaded " << counts.loaded << " course(s) as term \"" << name << "\"";
+        if (counts.skipped) log() << " (" << counts.skipped << " line(s) skipped for format issues)";
+        log() << ".\n";
+        reportValidation(*next, log());
+        return true;
+    }
+
+    // Points queries back at a loaded term. Nothing is reparsed.
+    bool useTerm(const std::string& name, std::string& outError) {
+        std::lock_guard<std::mutex> lock(loadMutex_);
+        std::shared_ptr<const Catalog> cat = findTerm(*termTable(), name);
+        if (!cat) {
+            outError = "Error: no term named \"" + name + "\" is loaded.";
+            return false;
+        }
+        std::atomic_store_explicit(&current_, cat, std::memory_order_release);
+        responses_.clear();
+        return true;
+    }
+
+    void printTerms(std::ostream& out) const {
+        std::shared_ptr<const TermTable> terms = termTable();
+        if (terms->empty()) {
+            out << "No terms are loaded.\n\n";
+            return;
+        }
+        std::shared_ptr<const Catalog> cur = catalog();
+        size_t own = 0, standalone = 0;
+        out << "\nTerms loaded:\n";
+        for (const auto& [name, cat] : *terms) {
+            out << "  " << name << ": " << cat->store->size() << " course(s) from \"" << cat->sourceFile << "\""
+                << (cat == cur ? " (current)" : "");
+            if (cat->sharedCourses) {
+                out << ", " << cat->sharedCourses << " of them shared with \"" << cat->editedFrom << "\"";
+            }
+            out << "; " << cat->ownBytes << " bytes of its own\n";
+            own += cat->ownBytes;
+            standalone += cat->standaloneBytes;
+        }
+        out << "Terms hold " << own << " bytes; loaded as separate catalogs they would take about " << standalone
+            << " bytes.\n\n";
+    }
+
+    // What changed from term `from` to term `to`, in course order: "+" added,
+    // "-" removed, "~" a new title and/or prereq list. Because terms agree on
+    // ids and share their strings, the walk compares two pointers per course
+    // that appears in both, and reads text only for courses that changed.
+    void printTermDiff(const std::string& from, const std::string& to, std::ostream& out) const {
+        static constexpr std::string_view kRule = "-----------------------------------------\n";
+        std::shared_ptr<const TermTable> terms = termTable();
+        std::shared_ptr<const Catalog> a = findTerm(*terms, from), b = findTerm(*terms, to);
+        if (!a || !b) {
+            out << "Error: no term named \"" << (a ? to : from) << "\" is loaded.\n";
+            return;
+        }
+
+        std::string buf;
+        buf.append("\nChanges from ").append(from).append(" to ").append(to).append("\n").append(kRule);
+        auto line = [&](char mark, const Course& c) {
+            buf.append("  ").append(1, mark).append(" ").append(c.number).append(": ").append(c.title);
+        };
+        auto sameList = [](Span<CourseId> x, Span<CourseId> y) {
+            return x.begin() == y.begin() ? x.size() == y.size()
+                                          : std::equal(x.begin(), x.end(), y.begin(), y.end());
+        };
+
+        size_t added = 0, changed = 0, removed = 0, same = 0;
+        std::vector<const Course*> incoming;
+        incoming.reserve(b->store->size());
+        b->store->inOrder([&](const Course& c) { incoming.push_back(&c); });
+        auto it = incoming.begin();
+        const auto end = incoming.end();
+        auto addedUpTo = [&](const Course* prev) {
+            for (; it != end && (!prev || numberLess(**it, *prev)); ++it) {
+                line('+', **it);
+                buf.push_back('\n');
+                ++added;
+            }
+        };
+        a->store->inOrder([&](const Course& prev) {
+            addedUpTo(&prev);
+            if (it == end || (*it)->id != prev.id) {
+                line('-', prev);
+                buf.push_back('\n');
+                ++removed;
+                return;
+            }
+            const Course& next = **it++;
+            const bool title = next.title.data() != prev.title.data() && next.title != prev.title;
+            const bool prereqs = !sameList(prev.prereqs, next.prereqs);
+            if (!title && !prereqs) {
+                ++same;
+                return;
+            }
+            line('~', next);
+            buf.append(title && prereqs ? " [title and prereqs changed]\n"
+                                        : title ? " [title changed]\n" : " [prereqs changed]\n");
+            ++changed;
+        });
+        addedUpTo(nullptr);
+
+        buf.append(kRule).append("Total: ").append(std::to_string(added)).append(" added, ");
+        buf.append(std::to_string(changed)).append(" changed, ").append(std::to_string(removed)).append(" removed, ");
+        buf.append(std::to_string(same)).append(" unchanged.\n\n");
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+
+    bool isLoaded() const { return catalog() != nullptr; }
+
+    // Where load, reload and snapshot progress messages go (std::cout by default).
+    // Not synchronized: set it before loading from several threads.
+    void setLog(std::ostream& log) { log_ = &log; }
+
+    // Sizes the rendered-response cache (0 disables it). Resets its counters;
+    // call before serving queries.
+    void setResponseCacheCapacity(size_t entries) { responses_.setCapacity(entries); }
+
+    // Picks the store for catalogs loaded from now on; the published catalog
+    // keeps the one it was built with. Not synchronized with loaders.
+    void setStoreKind(StoreKind kind) { storeKind_ = kind; }
+    ResponseCache::Stats responseCacheStats() const { return responses_.stats(); }
+
+    // Load timers, lookup latency histograms, catalog gauges and response cache
+    // counters in Prometheus text exposition format.
+    void writeStats(std::ostream& out) const {
+        std::string buf;
+        stats_.appendPrometheus(buf);
+        std::shared_ptr<const Catalog> cat = catalog();
+        auto gauge = [&](const char* name, const char* help, uint64_t value) {
+            buf.append("# HELP ").append(name).append(" ").append(help).append("\n");
+            buf.append("# TYPE ").append(name).append(" gauge\n");
+            buf.append(name).append(" ").append(std::to_string(value)).append("\n");
+        };
+        auto counter = [&](const char* name, const char* help, uint64_t value) {
+            buf.append("# HELP ").append(name).append(" ").append(help).append("\n");
+            buf.append("# TYPE ").append(name).append(" counter\n");
+            buf.append(name).append(" ").append(std::to_string(value)).append("\n");
+        };
+        gauge("advising_catalog_courses", "Courses in the loaded catalog.", cat ? cat->store->size() : 0);
+        gauge("advising_catalog_symbols", "Interned course numbers, including missing prereqs.",
+              cat ? cat->symbols.size() : 0);
+        gauge("advising_catalog_tree_height", "Levels a lookup descends in the course store.",
+              cat ? static_cast<uint64_t>(cat->store->height()) : 0);
+        if (cat) {
+            buf.append("# HELP advising_catalog_store_info Backend holding the loaded catalog.\n");
+            buf.append("# TYPE advising_catalog_store_info gauge\n");
+            buf.append("advising_catalog_store_info{store=\"").append(cat->store->kind()).append("\"} 1\n");
+        }
+        gauge("advising_catalog_arena_bytes", "Heap bytes held by the arena of the catalog's pool.",
+              cat ? cat->pool->bytesReserved() : 0);
+        gauge("advising_catalog_own_bytes", "Bytes the catalog added to its pool, plus its heap tables.",
+              cat ? cat->ownBytes : 0);
+        gauge("advising_catalog_shared_courses", "Course records shared with the catalog this one was edited from.",
+              cat ? cat->sharedCourses : 0);
+        gauge("advising_terms", "Named term catalogs loaded.", termTable()->size());
+        gauge("advising_term_pool_bytes", "Heap bytes held by the pool terms share.",
+              termPoolBytes_.load(std::memory_order_relaxed));
+        const ResponseCache::Stats cache = responses_.stats();
+        counter("advising_response_cache_hits_total", "Rendered responses served from the cache.", cache.hits);
+        counter("advising_response_cache_misses_total", "Rendered responses that had to be built.", cache.misses);
+        gauge("advising_response_cache_entries", "Rendered responses currently cached.", cache.entries);
+        gauge("advising_response_cache_capacity", "Maximum rendered responses cached.", cache.capacity);
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+
+    // The catalog queries currently see (null before the first load). Holding
+    // the pointer keeps that catalog alive across later reloads.
+    std::shared_ptr<const Catalog> catalog() const { return std::atomic_load_explicit(&current_, std::memory_order_acquire); }
+
+    void printCourseList(std::ostream& out) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "Please load data first (Option 1).\n";
+            return;
+        }
+        const std::string& list = cat->courseList();
+        out.write(list.data(), static_cast<std::streamsize>(list.size()));
+    }
+
+    // Streams the whole sorted catalog as NDJSON, one course object per line:
+    //   {"number":"CSCI200","title":"Data Structures","prereqs":["CSCI101"]}
+    // Lines are serialized straight from the in-order walk into a bounded buffer.
+    void writeCourseListNdjson(std::ostream& out) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "{\"error\":\"no catalog loaded\"}\n";
+            return;
+        }
+        writeNdjson(*cat, [&](auto&& line) { cat->store->inOrder(line); }, out);
+    }
+
+    // One course with resolved prereqs as a single-line JSON object:
+    //   {"number":"CSCI300","title":"...","inCycle":false,
+    //    "prereqs":[{"number":"CSCI200","title":"Data Structures"},{"number":"X","title":null}]}
+    // A null title marks a prereq missing from the file. Misses produce
+    //   {"number":"X","error":"not found","suggestions":["CSCI200"]}
+    // Returns whether the course was found.
+    bool writeCourseJson(const std::string& rawNumber, std::ostream& out) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "{\"error\":\"no catalog loaded\"}\n";
+            return false;
+        }
+        std::string buf;
+        const Course* c = findForJson(*cat, rawNumber, buf);
+        if (!c) {
+            out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            return false;
+        }
+        std::string cached;
+        if (responses_.find(cat->generation, c->id, ResponseCache::kCourseJson, cached)) {
+            out.write(cached.data(), static_cast<std::streamsize>(cached.size()));
+            return true;
+        }
+        buf.append(",\"title\":");
+        appendJsonString(buf, c->title);
+        buf.append(cat->diagnostics.has(c->id, CatalogDiagnostics::kInCycle) ? ",\"inCycle\":true" : ",\"inCycle\":false");
+        buf.append(",\"prereqs\":[");
+        for (size_t i = 0; i < c->prereqs.size(); ++i) {
+            const CourseId p = c->prereqs[i];
+            const bool defined = cat->diagnostics.has(p, CatalogDiagnostics::kDefined);
+            if (i) buf.push_back(',');
+            appendJsonPrereq(buf, cat->symbols.name(p), defined ? cat->graph.course(p)->title : std::string_view{},
+                             defined);
+        }
+        buf.append("]}\n");
+        responses_.insert(cat->generation, c->id, ResponseCache::kCourseJson, buf);
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        return true;
+    }
+
+    // JSON form of printPrereqChain, prereqs in a valid order to take them:
+    //   {"number":"CSCI300","title":"...","inCycle":false,"chain":["CSCI100","CSCI200"]}
+    // Misses produce the same object as writeCourseJson. Returns whether the
+    // course was found.
+    bool writePrereqChainJson(const std::string& rawNumber, std::ostream& out) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "{\"error\":\"no catalog loaded\"}\n";
+            return false;
+        }
+        std::string buf;
+        const Course* c = findForJson(*cat, rawNumber, buf);
+        if (!c) {
+            out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            return false;
+        }
+        std::vector<CourseId> scratch;
+        const std::vector<CourseId>& chain = cat->prereqChain(c->id, scratch);
+
+        buf.append(",\"title\":");
+        appendJsonString(buf, c->title);
+        buf.append(cat->diagnostics.has(c->id, CatalogDiagnostics::kInCycle) ? ",\"inCycle\":true" : ",\"inCycle\":false");
+        buf.append(",\"chain\":[");
+        for (size_t i = 0; i < chain.size(); ++i) {
+            if (i) buf.push_back(',');
+            appendJsonString(buf, cat->symbols.name(chain[i]));
+        }
+        buf.append("]}\n");
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        return true;
+    }
+
+    // JSON form of printDependents, both lists in course-number order:
+    //   {"number":"CSCI200","title":"...","direct":["CSCI300"],"all":["CSCI300","CSCI400"]}
+    // Misses produce the same object as writeCourseJson. Returns whether the
+    // course was found.
+    bool writeDependentsJson(const std::string& rawNumber, std::ostream& out) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "{\"error\":\"no catalog loaded\"}\n";
+            return false;
+        }
+        std::string buf;
+        const Course* c = findForJson(*cat, rawNumber, buf);
+        if (!c) {
+            out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            return false;
+        }
+        const Span<CourseId> direct = cat->graph.dependents(c->id);
+        std::vector<CourseId> scratch;
+        const std::vector<CourseId>& all = cat->allDependents(c->id, scratch);
+
+        buf.append(",\"title\":");
+        appendJsonString(buf, c->title);
+        buf.append(",\"direct\":[");
+        for (size_t i = 0; i < direct.size(); ++i) {
+            if (i) buf.push_back(',');
+            appendJsonString(buf, cat->symbols.name(direct[i]));
+        }
+        buf.append("],\"all\":[");
+        for (size_t i = 0; i < all.size(); ++i) {
+            if (i) buf.push_back(',');
+            appendJsonString(buf, cat->symbols.name(all[i]));
+        }
+        buf.append("]}\n");
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        return true;
+    }
+
+    // Resolves many numbers in one pass (a degree audit checks dozens per
+    // student), one line each in the order given:
+    //   CSCI200, Data Structures
+    //   MATH999 (not found)
+    void printCourseLookup(std::vector<std::string> numbers, std::ostream& out) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "Please load data first (Option 1).\n";
+            return;
+        }
+        const std::vector<const Course*> found = findCourses(*cat, numbers);
+        std::string buf;
+        size_t hits = 0;
+        for (size_t i = 0; i < numbers.size(); ++i) {
+            if (const Course* c = found[i]) {
+                appendListLine(buf, c->number, c->title);
+                ++hits;
+            } else {
+                buf.append(numbers[i]).append(" (not found)\n");
+            }
+        }
+        appendLookupTotal(buf, hits, numbers.size());
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+
+    // NDJSON form of printCourseLookup: found courses as in writeCourseListNdjson,
+    // misses as {"number":"X","error":"not found"}.
+    void writeCourseLookupNdjson(std::vector<std::string> numbers, std::ostream& out) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "{\"error\":\"no catalog loaded\"}\n";
+            return;
+        }
+        const std::vector<const Course*> found = findCourses(*cat, numbers);
+        std::string buf;
+        for (size_t i = 0; i < numbers.size(); ++i) {
+            if (found[i]) {
+                appendNdjson(*cat, buf, *found[i]);
+            } else {
+                appendLookupMissNdjson(buf, numbers[i]);
+            }
+        }
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+
+    // Lists the courses lo <= number <= hi (both normalized to uppercase), or
+    // with `hi` empty, every course whose number starts with `lo`.
+    void printCourseRange(const std::string& rawLo, const std::string& rawHi, std::ostream& out) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "Please load data first (Option 1).\n";
+            return;
+        }
+        std::string lo, hi;
+        if (!normalizeRange(rawLo, rawHi, lo, hi)) {
+            out << "Error: course number cannot be empty.\n";
+            return;
+        }
+
+        std::string buf;
+        appendListHeading(buf, rangeHeading(lo, hi));
+        size_t count = 0;
+        auto line = [&](const Course& c) {
+            appendListLine(buf, c.number, c.title);
+            ++count;
+        };
+        if (hi.empty()) {
+            cat->store->visitPrefix(lo, line);
+        } else {
+            cat->store->visitRange(lo, hi, line);
+        }
+        appendListTotal(buf, count);
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+
+    // NDJSON form of printCourseRange.
+    void writeCourseRangeNdjson(const std::string& rawLo, const std::string& rawHi, std::ostream& out) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "{\"error\":\"no catalog loaded\"}\n";
+            return;
+        }
+        std::string lo, hi;
+        if (!normalizeRange(rawLo, rawHi, lo, hi)) {
+            out << "{\"error\":\"empty course number\"}\n";
+            return;
+        }
+        if (hi.empty()) {
+            writeNdjson(*cat, [&](auto&& line) { cat->store->visitPrefix(lo, line); }, out);
+        } else {
+            writeNdjson(*cat, [&](auto&& line) { cat->store->visitRange(lo, hi, line); }, out);
+        }
+    }
+
+    // Lists courses whose titles contain every word of `query` (case-insensitive;
+    // a trailing '*' makes a word a prefix), in course-number order.
+    void printTitleSearch(const std::string& query, std::ostream& out) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "Please load data first (Option 1).\n";
+            return;
+        }
+        std::vector<const Course*> hits;
+        cat->titles().search(query, hits);
+
+        std::string buf;
+        appendListHeading(buf, "Courses matching \"" + std::string(trimView(query)) + "\"");
+        for (const Course* c : hits) appendListLine(buf, c->number, c->title);
+        appendListTotal(buf, hits.size());
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+
+    // NDJSON form of printTitleSearch.
+    void writeTitleSearchNdjson(const std::string& query, std::ostream& out) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "{\"error\":\"no catalog loaded\"}\n";
+            return;
+        }
+        std::vector<const Course*> hits;
+        cat->titles().search(query, hits);
+        std::string buf;
+        for (const Course* c : hits) appendNdjson(*cat, buf, *c);
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+
+    void printCourseInfo(const std::string& rawNumber, std::ostream& out) const {
+        PlannerStats::Scope timed(stats_.courseInfo);
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "Please load data first (Option 1).\n";
+            return;
+        }
+        std::string number = trimCopy(rawNumber);
+        toUpperInPlace(number);
+        if (number.empty()) {
+            out << "Error: course number cannot be empty.\n";
+            return;
+        }
+
+        const Course* c = findCourse(*cat, number);
+        if (!c) {
+            printNotFound(*cat, number, out);
+            return;
+        }
+
+        std::string buf;
+        if (!responses_.find(cat->generation, c->id, ResponseCache::kInfoText, buf)) {
+            appendCourseHeading(buf, c->number, c->title);
+            if (c->prereqs.empty()) {
+                buf.append("Prerequisites: None\n\n");
+            } else {
+                buf.append("Prerequisites:\n");
+                appendPrereqLines(*cat, c->prereqs.begin(), c->prereqs.end(), buf);
+                if (cat->diagnostics.has(c->id, CatalogDiagnostics::kInCycle)) {
+                    buf.append("Note: ").append(c->number).append(" is part of a prerequisite cycle.\n");
+                }
+                buf.push_back('\n');
+            }
+            responses_.insert(cat->generation, c->id, ResponseCache::kInfoText, buf);
+        }
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+
+    // Prints every course that must be completed before `rawNumber`, in an
+    // order that satisfies their own prerequisites.
+    void printPrereqChain(const std::string& rawNumber, std::ostream& out) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "Please load data first (Option 1).\n";
+            return;
+        }
+        std::string number = trimCopy(rawNumber);
+        toUpperInPlace(number);
+        if (number.empty()) {
+            out << "Error: course number cannot be empty.\n";
+            return;
+        }
+
+        const Course* c = findCourse(*cat, number);
+        if (!c) {
+            printNotFound(*cat, number, out);
+            return;
+        }
+
+        std::vector<CourseId> scratch;
+        const std::vector<CourseId>& chain = cat->prereqChain(c->id, scratch);
+
+        out << "\n" << c->number << ": " << c->title << "\n";
+        if (chain.empty()) {
+            out << "All prerequisites: None\n\n";
+            return;
+        }
+        if (cat->diagnostics.has(c->id, CatalogDiagnostics::kInCycle)) {
+            out << "All prerequisites (" << chain.size() << "; " << c->number
+                      << " is part of a prerequisite cycle, so no order satisfies them all):\n";
+        } else {
+            out << "All prerequisites (" << chain.size() << ", in a valid order to take them):\n";
+        }
+        std::string lines;
+        appendPrereqLines(*cat, chain.data(), chain.data() + chain.size(), lines);
+        lines.push_back('\n');
+        out.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+    }
+
+    // Prints the courses that list `rawNumber` as a prerequisite, then every
+    // course that would be blocked without it (directly or through others).
+    void printDependents(const std::string& rawNumber, std::ostream& out) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "Please load data first (Option 1).\n";
+            return;
+        }
+        std::string number = trimCopy(rawNumber);
+        toUpperInPlace(number);
+        if (number.empty()) {
+            out << "Error: course number cannot be empty.\n";
+            return;
+        }
+
+        const Course* c = findCourse(*cat, number);
+        if (!c) {
+            printNotFound(*cat, number, out);
+            return;
+        }
+
+        const Span<CourseId> direct = cat->graph.dependents(c->id);
+        out << "\n" << c->number << ": " << c->title << "\n";
+        if (direct.empty()) {
+            out << "Required by: None\n\n";
+            return;
+        }
+        std::vector<CourseId> scratch;
+        const std::vector<CourseId>& all = cat->allDependents(c->id, scratch);
+        std::string lines;
+        lines.append("Required directly by (").append(std::to_string(direct.size())).append("):\n");
+        appendPrereqLines(*cat, direct.begin(), direct.end(), lines);
+        lines.append("Blocked without it (").append(std::to_string(all.size()))
+            .append(", directly or through other courses):\n");
+        appendPrereqLines(*cat, all.data(), all.data() + all.size(), lines);
+        lines.push_back('\n');
+        out.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+    }
+
+    // Plans terms for `targets` given `completed` courses and a per-term cap.
+    // Each unknown target number is reported and the rest are still planned;
+    // unknown completed numbers are ignored.
+    void printTermPlan(const std::vector<std::string>& targets, const std::vector<std::string>& completed,
+                       size_t maxPerTerm, std::ostream& out) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            out << "Please load data first (Option 1).\n";
+            return;
+        }
+        if (targets.empty()) {
+            out << "Error: enter at least one target course.\n";
+            return;
+        }
+
+        std::vector<CourseId> targetIds, completedIds;
+        for (const std::string& t : targets) {
+            const Course* c = findCourse(*cat, t);
+            if (c) {
+                targetIds.push_back(c->id);
+            } else {
+                printNotFound(*cat, t, out);
+            }
+        }
+        if (targetIds.empty()) return;
+        for (const std::string& done : completed) {
+            CourseId id = cat->symbols.find(done);
+            if (id != kNoCourse) completedIds.push_back(id);
+        }
+
+        TermPlan plan;
+        scheduler_.plan(cat->graph, cat->diagnostics, targetIds, completedIds, maxPerTerm, plan);
+
+        out << "\n";
+        if (plan.terms.empty() && plan.unschedulable.empty()) {
+            out << "Nothing left to take: every target is already completed.\n\n";
+            return;
+        }
+        for (size_t t = 0; t < plan.terms.size(); ++t) {
+            out << "Term " << t + 1 << ":";
+            for (size_t i = 0; i < plan.terms[t].size(); ++i) {
+                out << (i ? ", " : " ") << cat->symbols.name(plan.terms[t][i]);
+            }
+            out << "\n";
+        }
+        if (!plan.unschedulable.empty()) {
+            out << "Cannot be scheduled (missing from the file, in a prerequisite cycle, or blocked by one):";
+            for (size_t i = 0; i < plan.unschedulable.size(); ++i) {
+                out << (i ? ", " : " ") << cat->symbols.name(plan.unschedulable[i]);
+            }
+            out << "\n";
+        }
+        out << "\n";
+    }
+
+    // File the current catalog came from (empty before the first load).
+    std::string lastFilename() const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        return cat ? cat->sourceFile : std::string();
+    }
+
+    // Writes the loaded catalog to `path` as a binary snapshot. The file is
+    // written beside its destination and renamed into place.
+    bool saveSnapshot(const std::string& path, std::string& outError) const {
+        std::shared_ptr<const Catalog> cat = catalog();
+        if (!cat) {
+            outError = "Please load data first (Option 1).";
+            return false;
+        }
+
+        std::vector<SnapshotString> names;
+        std::vector<SnapshotCourse> courses;
+        std::vector<CourseId> prereqs;
+        std::string pool;
+        auto addString = [&](std::string_view sv) {
+            SnapshotString ss{pool.size(), sv.size()};
+            pool.append(sv.data(), sv.size());
+            return ss;
+        };
+
+        names.reserve(cat->symbols.size());
+        for (size_t id = 0; id < cat->symbols.size(); ++id) {
+            names.push_back(addString(cat->symbols.name(static_cast<CourseId>(id))));
+        }
+        courses.reserve(cat->store->size());
+        cat->store->inOrder([&](const Course& c) {
+            courses.push_back({c.id, static_cast<uint32_t>(c.prereqs.size()), prereqs.size(), addString(c.title)});
+            prereqs.insert(prereqs.end(), c.prereqs.begin(), c.prereqs.end());
+        });
+
+        SnapshotHeader h{};
+        std::memcpy(h.magic, kSnapshotMagic, sizeof h.magic);
+        h.version = kSnapshotVersion;
+        h.byteOrder = kSnapshotByteOrder;
+        h.sourceSize = cat->sourceStamp.size;
+        h.sourceMtimeNs = cat->sourceStamp.mtimeNs;
+        h.sourcePathLength = static_cast<uint32_t>(cat->sourceFile.size());
+        h.symbolCount = static_cast<uint32_t>(names.size());
+        h.courseCount = static_cast<uint32_t>(courses.size());
+        h.prereqCount = prereqs.size();
+        h.stringBytes = pool.size();
+
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                outError = "Error: Could not write snapshot \"" + path + "\".";
+                return false;
+            }
+            const char zeros[8] = {};
+            auto put = [&](const void* p, size_t n) {
+                out.write(static_cast<const char*>(p), static_cast<std::streamsize>(n));
+                out.write(zeros, static_cast<std::streamsize>(alignUp8(n) - n));
+            };
+            put(&h, sizeof h);
+            put(cat->sourceFile.data(), cat->sourceFile.size());
+            put(names.data(), names.size() * sizeof(SnapshotString));
+            put(courses.data(), courses.size() * sizeof(SnapshotCourse));
+            put(prereqs.data(), prereqs.size() * sizeof(CourseId));
+            put(pool.data(), pool.size());
+            if (!out.flush()) {
+                outError = "Error: Could not write snapshot \"" + path + "\".";
+                std::remove(tmp.c_str());
+                return false;
+            }
+        }
+#ifndef ADVISING_HAVE_MMAP
+        std::remove(path.c_str()); // rename() does not replace files everywhere
+#endif
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            outError = "Error: Could not replace snapshot \"" + path + "\".";
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // Maps a snapshot written by saveSnapshot and serves the catalog from it.
+    // `source` names the CSV the snapshot must be current with; when empty it is
+    // set to the path recorded in the snapshot, so a caller can fall back to it.
+    // Fails without touching the loaded catalog if the snapshot is stale or
+    // malformed.
+    bool loadSnapshot(const std::string& path, std::string& source, std::string& outError) {
+        std::lock_guard<std::mutex> lock(loadMutex_);
+        StatsTime t = statsNow();
+        auto snap = std::make_unique<MappedFile>();
+        if (!snap->open(path)) {
+            outError = "Snapshot \"" + path + "\" could not be opened.";
+            return false;
+        }
+        t = stats_.phase(PlannerStats::kMap, t);
+        const std::string_view buf = snap->data();
+        auto malformed = [&] {
+            outError = "Snapshot \"" + path + "\" is not a valid catalog snapshot.";
+            return false;
+        };
+
+        SnapshotHeader h;
+        if (buf.size() < sizeof h) return malformed();
+        std::memcpy(&h, buf.data(), sizeof h);
+        if (std::memcmp(h.magic, kSnapshotMagic, sizeof h.magic) != 0 ||
+            h.version != kSnapshotVersion || h.byteOrder != kSnapshotByteOrder) {
+            return malformed();
+        }
+
+        const uint64_t pathAt = alignUp8(sizeof h);
+        const uint64_t namesAt = pathAt + alignUp8(h.sourcePathLength);
+        const uint64_t coursesAt = namesAt + alignUp8(uint64_t{h.symbolCount} * sizeof(SnapshotString));
+        const uint64_t prereqsAt = coursesAt + alignUp8(uint64_t{h.courseCount} * sizeof(SnapshotCourse));
+        const uint64_t poolAt = prereqsAt + alignUp8(h.prereqCount * sizeof(CourseId));
+        if (h.prereqCount > buf.size() || h.stringBytes > buf.size() || poolAt + h.stringBytes > buf.size()) {
+            return malformed();
+        }
+
+        const std::string recorded(buf.data() + pathAt, h.sourcePathLength);
+        if (source.empty()) source = recorded;
+        FileStamp current;
+        if (!statFile(source, current) || current != FileStamp{h.sourceSize, h.sourceMtimeNs}) {
+            outError = "Snapshot \"" + path + "\" is out of date.";
+            return false;
+        }
+
+        const auto* names = reinterpret_cast<const SnapshotString*>(buf.data() + namesAt);
+        const auto* courses = reinterpret_cast<const SnapshotCourse*>(buf.data() + coursesAt);
+        const auto* prereqs = reinterpret_cast<const CourseId*>(buf.data() + prereqsAt);
+        const char* pool = buf.data() + poolAt;
+        auto view = [&](const SnapshotString& ss, std::string_view& out) {
+            if (ss.offset > h.stringBytes || ss.length > h.stringBytes - ss.offset) return false;
+            out = {pool + ss.offset, static_cast<size_t>(ss.length)};
+            return true;
+        };
+
+        std::vector<std::string_view> symbolNames(h.symbolCount);
+        for (uint32_t i = 0; i < h.symbolCount; ++i) {
+            if (!view(names[i], symbolNames[i])) return malformed();
+        }
+        for (uint64_t i = 0; i < h.prereqCount; ++i) {
+            if (prereqs[i] >= h.symbolCount) return malformed();
+        }
+        std::vector<Course> rows(h.courseCount);
+        for (uint32_t i = 0; i < h.courseCount; ++i) {
+            const SnapshotCourse& sc = courses[i];
+            Course& c = rows[i];
+            if (sc.id >= h.symbolCount || sc.firstPrereq > h.prereqCount ||
+                sc.prereqCount > h.prereqCount - sc.firstPrereq || !view(sc.title, c.title)) {
+                return malformed();
+            }
+            c.id = sc.id;
+            c.number = symbolNames[sc.id];
+            c.key = CourseKey::from(c.number);
+            c.prereqs = {prereqs + sc.firstPrereq, sc.prereqCount};
+            if (i > 0 && !internedLess(rows[i - 1], c)) return malformed();
+        }
+        if (rows.empty()) return malformed();
+        t = stats_.phase(PlannerStats::kParse, t);
+
+        auto backing = std::make_shared<CatalogPool>();
+        backing->symbols().adopt(symbolNames);
+        backing->snapshot = std::move(snap);
+        auto next = std::make_shared<Catalog>(storeKind_, backing);
+        next->storeCourses(rows);
+        t = stats_.phase(PlannerStats::kBuild, t);
+        next->buildIndexes();
+        stats_.phase(PlannerStats::kIndex, t);
+        stats_.loaded();
+        backing->fullBuildBytes = backing->bytesReserved();
+        next->ownBytes = next->standaloneBytes = backing->bytesReserved() + next->heapBytes();
+        next->sourceFile = source;
+        next->sourceStamp = current;
+        publish(next);
+
+        log() << "Loaded " << next->store->size() << " course(s) from snapshot \"" << path << "\".\n";
+        reportValidation(*next, log());
+        return true;
+    }
+
+private:
+    // What one parseCatalog call read and, given a base catalog, how the new
+    // courses compare with it.
+    struct LoadCounts {
+        size_t loaded = 0;  // accepted rows, duplicates included
+        size_t skipped = 0; // malformed lines
+        size_t added = 0, changed = 0, removed = 0;
+    };
+
+    // Maps and parses `filename` into a complete, unpublished catalog. A
+    // nonempty `term` builds it as that term, in the term pool. With `base`
+    // (the catalog being reloaded, or the latest term), the rows are numbered
+    // in base's pool and compared with its courses; if few enough changed, the
+    // catalog is built as an edit of base that shares everything else (see
+    // Catalog::buildEdit). Returns null with `outError` set when nothing usable
+    // was read, or when `progress` was cancelled. Callers hold loadMutex_.
+    std::shared_ptr<Catalog> parseCatalog(const std::string& filename, LoadCounts& counts, std::string& outError,
+                                          const std::string& term = std::string(), const Catalog* base = nullptr,
+                                          LoadProgress* progress = nullptr) {
+        // Moves `progress` on to phase `p`; false once the load is cancelled.
+        auto enter = [&](PlannerStats::Phase p) {
+            if (!progress) return true;
+            progress->phase.store(p, std::memory_order_relaxed);
+            if (!progress->cancel.load(std::memory_order_relaxed)) return true;
+            outError = "Load of \"" + filename + "\" was cancelled.";
+            return false;
+        };
+
+        StatsTime t = statsNow();
+        MappedFile file;
+        if (!enter(PlannerStats::kMap)) return nullptr;
+        if (!file.open(filename)) {
+            outError = "Error: Could not open file \"" + filename + "\".";
+            return nullptr;
+        }
+        t = stats_.phase(PlannerStats::kMap, t);
+        if (progress) progress->bytesTotal.store(file.data().size(), std::memory_order_relaxed);
+
+        // Lines are tokenized in place as views into the mapping; strings are only
+        // materialized when a record is committed to the arena.
+        std::vector<ParsedChunk> chunks;
+        if (!enter(PlannerStats::kParse)) return nullptr;
+        parseChunks(file.data(), chunks, progress);
+        t = stats_.phase(PlannerStats::kParse, t);
+        if (!enter(PlannerStats::kIntern)) return nullptr;
+
+        std::shared_ptr<CatalogPool> pool;
+        if (!term.empty()) {
+            if (!termPool_) termPool_ = std::make_shared<CatalogPool>();
+            pool = termPool_;
+        } else {
+            pool = base ? base->pool : std::make_shared<CatalogPool>();
+        }
+        if (base && base->pool != pool) base = nullptr;
+        size_t poolBefore = pool->bytesReserved();
+
+        std::vector<Course> rows;
+        std::vector<CourseId> prereqs;
+        counts.skipped = stageRows(chunks, pool->symbols(), rows, prereqs,
+                                   progress && progress->messages ? *progress->messages : std::cerr);
+        counts.loaded = rows.size();
+        t = stats_.phase(PlannerStats::kIntern, t);
+        if (rows.empty()) {
+            outError = "Error: No valid course records were loaded from the file.";
+            return nullptr;
+        }
+
+        // Sort once and build the store in a single pass instead of n inserts.
+        if (!enter(PlannerStats::kSort)) return nullptr;
+        sortAndDedupe(rows);
+        t = stats_.phase(PlannerStats::kSort, t);
+        if (!enter(PlannerStats::kBuild)) return nullptr;
+
+        std::vector<const Course*> merged;
+        std::vector<CourseEdit> edits;
+        std::vector<size_t> slots;
+        if (base) {
+            diffRows(*base, rows, merged, edits, slots);
+            for (const CourseEdit& e : edits) {
+                ++(!e.before ? counts.added : !e.after ? counts.removed : counts.changed);
+            }
+        }
+
+        std::shared_ptr<Catalog> next;
+        // An edit pays per changed course and a full build per course, so past
+        // a quarter of the catalog changing, rebuild. A reload lineage also
+        // rebuilds once its pool holds as much again as its last full build
+        // (catalogs it replaced that nobody reads any more), in a fresh pool so
+        // the old one can go. The term pool is kept: every term in it is live.
+        const bool edit = base && base->kind == storeKind_ &&
+                          edits.size() * 4 <= std::max(rows.size(), base->store->size()) &&
+                          (!term.empty() || pool->bytesReserved() <= 2 * pool->fullBuildBytes);
+        if (edit) {
+            next = std::make_shared<Catalog>(storeKind_, pool);
+            // Changed and added courses get records of their own; a title or
+            // prereq list the course already had is kept rather than copied.
+            Arena& arena = pool->arena();
+            size_t slot = 0;
+            for (CourseEdit& e : edits) {
+                if (!e.after) continue;
+                Course c = *e.after;
+                if (e.before && e.before->title == c.title) {
+                    c.title = e.before->title;
+                } else {
+                    c.title = term.empty() ? arena.copy(c.title) : pool->intern(c.title);
+                }
+                if (e.before && std::equal(c.prereqs.begin(), c.prereqs.end(), e.before->prereqs.begin(),
+                                           e.before->prereqs.end())) {
+                    c.prereqs = e.before->prereqs;
+                } else if (term.empty()) {
+                    c.prereqs = {arena.copyArray(c.prereqs.begin(), c.prereqs.size()), c.prereqs.size()};
+                } else {
+                    c.prereqs = pool->intern(c.prereqs);
+                }
+                e.after = arena.make<Course>(c);
+                merged[slots[slot++]] = e.after;
+            }
+            next->buildEdit(*base, merged, edits);
+            for (const Course* c : merged) {
+                if (c->id < base->graph.vertexCount() && base->graph.course(c->id) == c) ++next->sharedCourses;
+            }
+            next->editedFrom = base->term;
+            t = stats_.phase(PlannerStats::kBuild, t);
+        } else {
+            std::vector<CourseId> renumbered;
+            if (base && term.empty()) {
+                pool = std::make_shared<CatalogPool>();
+                poolBefore = 0;
+                renumber(rows, base->pool->symbols(), pool->symbols(), renumbered);
+            }
+            next = std::make_shared<Catalog>(storeKind_, pool);
+
+            // Commit the surviving rows' strings into the pool. Titles go into
+            // one block in key order, so ordered walks read them sequentially.
+            // Terms intern them instead, so text repeated across terms is
+            // stored once.
+            Arena& arena = pool->arena();
+            if (!term.empty()) {
+                for (Course& c : rows) {
+                    c.title = pool->intern(c.title);
+                    c.prereqs = pool->intern(c.prereqs);
+                }
+            } else {
+                size_t titleBytes = 0;
+                for (const Course& c : rows) titleBytes += c.title.size();
+                char* titlePool = titleBytes ? static_cast<char*>(arena.allocate(titleBytes, 1)) : nullptr;
+                for (Course& c : rows) {
+                    if (!c.title.empty()) {
+                        std::memcpy(titlePool, c.title.data(), c.title.size());
+                        c.title = {titlePool, c.title.size()};
+                        titlePool += c.title.size();
+                    }
+                    c.prereqs = {arena.copyArray(c.prereqs.begin(), c.prereqs.size()), c.prereqs.size()};
+                }
+            }
+            next->storeCourses(rows);
+            t = stats_.phase(PlannerStats::kBuild, t);
+            if (!enter(PlannerStats::kIndex)) return nullptr;
+            next->buildIndexes();
+            pool->fullBuildBytes = pool->bytesReserved() - poolBefore;
+        }
+        stats_.phase(PlannerStats::kIndex, t);
+        stats_.loaded();
+        next->ownBytes = pool->bytesReserved() - poolBefore + next->heapBytes();
+        next->standaloneBytes =
+            edit ? static_cast<size_t>(static_cast<double>(base->standaloneBytes) * next->store->size() /
+                                       base->store->size())
+                 : next->ownBytes;
+        if (!term.empty()) {
+            next->term = term;
+            latestTerm_ = next;
+            termPoolBytes_.store(pool->bytesReserved(), std::memory_order_relaxed);
+        }
+        next->sourceFile = filename;
+        next->sourceStamp = file.stamp();
+        return next;
+    }
+
+    // Compares `rows` (sorted, deduplicated and numbered in base's pool) with
+    // base's courses. `merged` gets the new catalog's courses in order: base's
+    // record for a course whose title and prereqs are unchanged, else the row.
+    // `edits` gets every other course, with `after` pointing at the row, and
+    // `slots` the position in `merged` of each edit that has an `after`.
+    static void diffRows(const Catalog& base, const std::vector<Course>& rows, std::vector<const Course*>& merged,
+                         std::vector<CourseEdit>& edits, std::vector<size_t>& slots) {
+        merged.reserve(rows.size());
+        auto it = rows.begin();
+        const auto end = rows.end();
+        auto add = [&](const Course* before, const Course& row) {
+            slots.push_back(merged.size());
+            merged.push_back(&row);
+            edits.push_back({before, &row});
+        };
+        base.store->inOrder([&](const Course& prev) {
+            for (; it != end && internedLess(*it, prev); ++it) add(nullptr, *it);
+            if (it == end || it->id != prev.id) {
+                edits.push_back({&prev, nullptr});
+                return;
+            }
+            if (it->title == prev.title && std::equal(it->prereqs.begin(), it->prereqs.end(), prev.prereqs.begin(),
+                                                      prev.prereqs.end())) {
+                merged.push_back(&prev);
+            } else {
+                add(&prev, *it);
+            }
+            ++it;
+        });
+        for (; it != end; ++it) add(nullptr, *it);
+    }
+
+    // Moves `rows` from the ids of `from` to those of `to`; their prereq spans
+    // then point into `prereqs`.
+    static void renumber(std::vector<Course>& rows, const CourseSymbols& from, CourseSymbols& to,
+                         std::vector<CourseId>& prereqs) {
+        size_t total = 0;
+        for (const Course& c : rows) total += c.prereqs.size();
+        prereqs.reserve(total); // never reallocates, so the spans below stay valid
+        for (Course& c : rows) {
+            c.id = to.intern(c.number, c.key);
+            c.number = to.name(c.id);
+            const CourseId* first = prereqs.data() + prereqs.size();
+            for (CourseId p : c.prereqs) prereqs.push_back(to.intern(from.name(p)));
+            c.prereqs = {first, c.prereqs.size()};
+        }
+    }
+
+    // Turns parsed chunks into rows with ids interned in `symbols`, printing a
+    // warning per malformed line to `warnings`, and returns the number of
+    // skipped lines.
+    // Titles still view the file and prereq spans point into `prereqs`; callers
+    // copy what they keep.
+    static size_t stageRows(const std::vector<ParsedChunk>& chunks, CourseSymbols& symbols, std::vector<Course>& rows,
+                            std::vector<CourseId>& prereqs, std::ostream& warnings) {
+        size_t totalRows = 0, totalPrereqs = 0;
+        for (const ParsedChunk& chunk : chunks) {
+            totalRows += chunk.rows.size();
+            totalPrereqs += chunk.prereqs.size();
+        }
+        rows.reserve(totalRows);
+        prereqs.reserve(totalPrereqs); // never reallocates, so the spans below stay valid
+
+        size_t lineBase = 0;
+        size_t skipped = 0;
+        for (const ParsedChunk& chunk : chunks) {
+            for (const ParsedRow& r : chunk.rows) {
+                Course c;
+                c.key = CourseKey::from(r.number);
+                c.id = symbols.intern(r.number, c.key);
+                c.number = symbols.name(c.id);
+                c.title = r.title;
+
+                const CourseId* first = prereqs.data() + prereqs.size();
+                for (size_t i = 0; i < r.prereqCount; ++i) {
+                    prereqs.push_back(symbols.intern(chunk.prereqs[r.firstPrereq + i]));
+                }
+                c.prereqs = {first, r.prereqCount};
+
+                rows.push_back(c);
+            }
+
+            // Warnings come out in file order; line numbers become absolute by
+            // offsetting with the lines in earlier chunks.
+            for (size_t bad : chunk.badLines) {
+                warnings << "Warning (line " << lineBase + bad
+                         << "): expected at least course number and title. Skipping line.\n";
+                ++skipped;
+            }
+            lineBase += chunk.lines;
+        }
+        return skipped;
+    }
+
+    // Stable sort keeps file order within equal keys; the last row for each
+    // course number wins, as a later line in the file overrides an earlier one.
+    static void sortAndDedupe(std::vector<Course>& rows) {
+        std::stable_sort(rows.begin(), rows.end(), [](const Course& a, const Course& b) { return internedLess(a, b); });
+        size_t kept = 0;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (i + 1 < rows.size() && rows[i + 1].id == rows[i].id) continue;
+            if (kept != i) rows[kept] = rows[i];
+            ++kept;
+        }
+        rows.erase(rows.begin() + static_cast<std::ptrdiff_t>(kept), rows.end());
+    }
+
+    // Serializes the courses `walk` hands to its callback as NDJSON into a
+    // bounded buffer that is flushed as it fills, so arbitrarily large exports
+    // never build a document.
+    template <typename Walk>
+    void writeNdjson(const Catalog& cat, Walk&& walk, std::ostream& out) const {
+        constexpr size_t kFlushBytes = 64 * 1024;
+        std::string buf;
+        buf.reserve(kFlushBytes + 1024);
+        walk([&](const Course& c) {
+            appendNdjson(cat, buf, c);
+            if (buf.size() >= kFlushBytes) {
+                out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+                buf.clear();
+            }
+        });
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+
+    const Course* findCourse(const Catalog& cat, std::string_view number) const {
+        PlannerStats::Scope timed(stats_.find);
+        return cat.store->find(number);
+    }
+
+    // Normalizes `numbers` in place and resolves them with one findMany call.
+    std::vector<const Course*> findCourses(const Catalog& cat, std::vector<std::string>& numbers) const {
+        std::vector<std::string_view> views;
+        views.reserve(numbers.size());
+        for (std::string& n : numbers) {
+            n = trimCopy(n);
+            toUpperInPlace(n);
+            views.push_back(n);
+        }
+        std::vector<const Course*> found(numbers.size());
+        PlannerStats::Scope timed(stats_.find, views.size());
+        cat.store->findMany({views.data(), views.size()}, found.data());
+        return found;
+    }
+
+    // Starts a JSON course object in `buf` with the normalized number and returns
+    // the course. On a miss the object is completed with the error (and any
+    // suggestions) and null is returned.
+    const Course* findForJson(const Catalog& cat, const std::string& rawNumber, std::string& buf) const {
+        std::string number = trimCopy(rawNumber);
+        toUpperInPlace(number);
+
+        buf.append("{\"number\":");
+        appendJsonString(buf, number);
+        if (number.empty()) {
+            buf.append(",\"error\":\"empty course number\"}\n");
+            return nullptr;
+        }
+        const Course* c = findCourse(cat, number);
+        if (!c) {
+            std::vector<std::string_view> close;
+            cat.suggestions().nearest(number, kSuggestions, kSuggestionDistance, close);
+            appendJsonMiss(buf, close);
+        }
+        return c;
+    }
+
+    static void appendNdjson(const Catalog& cat, std::string& buf, const Course& c) {
+        appendCourseNdjson(buf, c.number, c.title, [&](auto&& fn) {
+            for (CourseId p : c.prereqs) fn(cat.symbols.name(p));
+        });
+    }
+
+    // How many "did you mean" numbers a miss offers, and how many edits away.
+    static constexpr size_t kSuggestions = 3;
+    static constexpr uint32_t kSuggestionDistance = 2;
+
+    void printNotFound(const Catalog& cat, std::string_view number, std::ostream& out) const {
+        std::vector<std::string_view> close;
+        cat.suggestions().nearest(number, kSuggestions, kSuggestionDistance, close);
+        std::string buf;
+        appendNotFound(buf, number, close);
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+
+    // One "  - NUMBER: Title" line per id; ids the validation pass found missing
+    // from the file are flagged instead.
+    void appendPrereqLines(const Catalog& cat, const CourseId* first, const CourseId* last, std::string& buf) const {
+        for (; first != last; ++first) {
+            const CourseId p = *first;
+            const bool defined = cat.diagnostics.has(p, CatalogDiagnostics::kDefined);
+            appendPrereqLine(buf, cat.symbols.name(p), defined ? cat.graph.course(p)->title : std::string_view{}, defined);
+        }
+    }
+
+    void reportValidation(const Catalog& cat, std::ostream& out) const {
+        if (cat.diagnostics.missingRefs || cat.diagnostics.cyclicCourses) {
+            out << "Validation: " << cat.diagnostics.missingRefs << " prerequisite reference(s) to courses "
+                  << "not in the file; " << cat.diagnostics.cyclicCourses << " course(s) in prerequisite cycles.\n";
+        }
+    }
+
+    // loadFromFile's work. Callers hold loadMutex_.
+    bool loadLocked(const std::string& filename, std::string& outError, LoadProgress* progress = nullptr) {
+        LoadCounts counts;
+        std::shared_ptr<Catalog> next = parseCatalog(filename, counts, outError, std::string(), nullptr, progress);
+        if (!next) return false;
+        if (progress && progress->cancel.load(std::memory_order_relaxed)) {
+            outError = "Load of \"" + filename + "\" was cancelled.";
+            return false;
+        }
+        publish(next);
+
+        std::ostream& out = progress && progress->messages ? *progress->messages : log();
+        out << "Loaded " << counts.loaded << " course(s)";
+        if (counts.skipped) out << " (" << counts.skipped << " line(s) skipped for format issues)";
+        out << ".\n";
+        reportValidation(*next, out);
+        return true;
+    }
+
+    // Publishes a fully built catalog to readers. Callers hold loadMutex_.
+    // Cached responses from the previous catalog can no longer match, so they
+    // are freed as well.
+    void publish(const std::shared_ptr<Catalog>& next) {
+        next->generation = ++generations_;
+        std::atomic_store_explicit(&current_, std::shared_ptr<const Catalog>(next), std::memory_order_release);
+        responses_.clear();
+    }
+
+    // Loaded terms by name. Like the current catalog, the table is replaced
+    // whole on every change, so readers never lock it.
+    using TermTable = std::map<std::string, std::shared_ptr<const Catalog>, std::less<>>;
+
+    std::shared_ptr<const TermTable> termTable() const {
+        return std::atomic_load_explicit(&terms_, std::memory_order_acquire);
+    }
+
+    static std::shared_ptr<const Catalog> findTerm(const TermTable& terms, std::string_view name) {
+        auto it = terms.find(name);
+        return it == terms.end() ? nullptr : it->second;
+    }
+
+    // Registers a published term catalog. Callers hold loadMutex_.
+    void addTerm(const std::shared_ptr<Catalog>& cat) {
+        auto terms = std::make_shared<TermTable>(*termTable());
+        (*terms)[cat->term] = cat;
+        std::atomic_store_explicit(&terms_, std::shared_ptr<const TermTable>(std::move(terms)),
+                                   std::memory_order_release);
+    }
+
+    TermScheduler scheduler_;
+    StoreKind storeKind_{StoreKind::kAvl};
+    mutable ResponseCache responses_;
+    mutable PlannerStats stats_;
+    uint64_t generations_{0};                // catalogs published so far (under loadMutex_)
+    std::shared_ptr<const Catalog> current_; // only accessed through std::atomic_load/store
+    std::shared_ptr<const TermTable> terms_{std::make_shared<const TermTable>()}; // likewise
+    std::shared_ptr<CatalogPool> termPool_;     // created by the first term load (under loadMutex_)
+    std::shared_ptr<const Catalog> latestTerm_; // the next term is built as an edit of it (likewise)
+    std::atomic<uint64_t> termPoolBytes_{0};
+    std::mutex loadMutex_;                   // serializes loaders; readers never take it
+    std::ostream* log_{&std::cout};
+
+    std::ostream& log() const { return *log_; }
+};
+
+// ---------- Out-of-core paged catalog ----------
+//
+// With --paged FILE the catalog lives in a disk-resident B+-tree that is read
+// through a small buffer pool, so memory use stays flat however large the
+// catalog is. The file is bulk-loaded from the CSV without ever holding the
+// whole catalog: the CSV is read in bounded blocks, rows are gathered until
+// they fill the sort budget, then sorted and spilled to a run file. The runs
+// are merged (the last row for a course number wins, as in a normal load)
+// straight into leaf pages, and internal levels are built as leaves fill.
+//
+// Layout (native byte order, kPageSize pages):
+//   page 0           PagedHeader, then the source CSV path bytes
+//   leaf page        PageHead, uint16_t offsets[count], records in key order
+//   internal page    PageHead, count x (CourseKey, uint32_t child page)
+// A record is uint16_t numberLength, titleLength, prereqCount, the number and
+// title bytes, then prereqCount x (uint16_t length, bytes). Leaves are linked
+// in key order, and an internal entry's key is the first key below its child.
+
+constexpr char kPagedMagic[8] = {'A', 'B', 'C', 'U', 'P', 'A', 'G', 'E'};
+constexpr uint32_t kPagedVersion = 1;
+constexpr size_t kPageSize = 8192;
+constexpr uint16_t kLeafPage = 1;
+constexpr uint16_t kInternalPage = 2;
+
+struct PagedHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t pageSize;
+    uint32_t height;    // levels, 1 when the root is the only leaf
+    uint32_t rootPage;
+    uint32_t pageCount; // including this header page
+    uint64_t courseCount;
+    uint64_t sourceSize;
+    int64_t sourceMtimeNs;
+    uint32_t sourcePathLength;
+    uint32_t reserved;
+};
+
+struct PageHead {
+    uint16_t type;
+    uint16_t count; // records (leaf) or children (internal)
+    uint32_t next;  // following leaf in key order, 0 after the last
+};
+
+constexpr size_t kInternalEntry = sizeof(CourseKey) + sizeof(uint32_t);
+constexpr size_t kInternalFanout = (kPageSize - sizeof(PageHead)) / kInternalEntry;
+constexpr size_t kMaxPagedRecord = kPageSize - sizeof(PageHead) - sizeof(uint16_t);
+
+static void putU16(std::string& out, size_t v) {
+    const uint16_t u = static_cast<uint16_t>(v);
+    out.append(reinterpret_cast<const char*>(&u), sizeof u);
+}
+
+static uint16_t getU16(const char* p) {
+    uint16_t u;
+    std::memcpy(&u, p, sizeof u);
+    return u;
+}
+
+// Appends one record; fails (leaving `out` as it was) if it cannot fit a page.
+static bool encodePagedRecord(std::string_view number, std::string_view title, const std::string_view* prereqs,
+                              size_t prereqCount, std::string& out) {
+    size_t bytes = 6 + number.size() + title.size();
+    for (size_t i = 0; i < prereqCount; ++i) bytes += 2 + prereqs[i].size();
+    if (bytes > kMaxPagedRecord) return false; // also bounds every length below
+    putU16(out, number.size());
+    putU16(out, title.size());
+    putU16(out, prereqCount);
+    out.append(number.data(), number.size()).append(title.data(), title.size());
+    for (size_t i = 0; i < prereqCount; ++i) {
+        putU16(out, prereqs[i].size());
+        out.append(prereqs[i].data(), prereqs[i].size());
+    }
+    return true;
+}
+
+// One decoded record. Views point into the encoded bytes (for a lookup, a
+// buffer-pool frame) and last only as long as those do.
+struct PagedRecord {
+    std::string_view number;
+    std::string_view title;
+    size_t prereqCount{0};
+    std::string_view prereqBytes; // prereqCount x (uint16_t length, bytes)
+
+    template <typename Fn>
+    void forEachPrereq(Fn&& fn) const {
+        const char* p = prereqBytes.data();
+        for (size_t i = 0; i < prereqCount; ++i) {
+            const size_t n = getU16(p);
+            fn(std::string_view(p + 2, n));
+            p += 2 + n;
+        }
+    }
+};
+
+// Decodes the record at the start of `bytes`, checking every length against
+// the buffer so a damaged page cannot send a read past it.
+static bool decodePagedRecord(std::string_view bytes, PagedRecord& out) {
+    if (bytes.size() < 6) return false;
+    const size_t numberLength = getU16(bytes.data());
+    const size_t titleLength = getU16(bytes.data() + 2);
+    out.prereqCount = getU16(bytes.data() + 4);
+    size_t at = 6;
+    if (numberLength + titleLength > bytes.size() - at) return false;
+    out.number = bytes.substr(at, numberLength);
+    out.title = bytes.substr(at + numberLength, titleLength);
+    at += numberLength + titleLength;
+    const size_t prereqsAt = at;
+    for (size_t i = 0; i < out.prereqCount; ++i) {
+        if (bytes.size() - at < 2) return false;
+        const size_t n = getU16(bytes.data() + at);
+        if (n > bytes.size() - at - 2) return false;
+        at += 2 + n;
+    }
+    out.prereqBytes = bytes.substr(prereqsAt, at - prereqsAt);
+    return true;
+}
+
+// Fixed set of page frames over a read-only file, replaced with the clock
+// algorithm. Not thread-safe. A fetched page stays valid until the next fetch.
+class BufferPool {
+public:
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        size_t resident{0};
+        size_t capacity{0};
+    };
+
+    bool open(const std::string& path, size_t frames) {
+        file_.open(path, std::ios::binary);
+        if (!file_.is_open()) return false;
+        frames = std::max<size_t>(frames, 2);
+        data_.reset(new char[frames * kPageSize]);
+        pageOf_.assign(frames, kNoPage);
+        referenced_.assign(frames, 0);
+        frameOf_.reserve(frames);
+        return true;
+    }
+
+    // Null when the page cannot be read.
+    const char* fetch(uint32_t page) {
+        auto it = frameOf_.find(page);
+        if (it != frameOf_.end()) {
+            ++hits_;
+            referenced_[it->second] = 1;
+            return frame(it->second);
+        }
+        ++misses_;
+        // Sweep past recently used frames, clearing their bit as we go.
+        while (referenced_[hand_]) {
+            referenced_[hand_] = 0;
+            hand_ = (hand_ + 1) % pageOf_.size();
+        }
+        const size_t f = hand_;
+        hand_ = (hand_ + 1) % pageOf_.size();
+        if (pageOf_[f] != kNoPage) frameOf_.erase(pageOf_[f]);
+        pageOf_[f] = kNoPage;
+
+        file_.clear();
+        file_.seekg(static_cast<std::streamoff>(uint64_t{page} * kPageSize));
+        if (!file_.read(frame(f), static_cast<std::streamsize>(kPageSize))) return nullptr;
+        pageOf_[f] = page;
+        referenced_[f] = 1;
+        frameOf_.emplace(page, f);
+        return frame(f);
+    }
+
+    Stats stats() const { return {hits_, misses_, frameOf_.size(), pageOf_.size()}; }
+
+private:
+    static constexpr uint32_t kNoPage = UINT32_MAX;
+
+    std::ifstream file_;
+    std::unique_ptr<char[]> data_;
+    std::vector<uint32_t> pageOf_;   // frame -> page it holds
+    std::vector<uint8_t> referenced_;
+    std::unordered_map<uint32_t, size_t> frameOf_;
+    size_t hand_{0};
+    uint64_t hits_{0};
+    uint64_t misses_{0};
+
+    char* frame(size_t f) { return data_.get() + f * kPageSize; }
+};
+
+// A course copied out of its page, so it outlives later page fetches.
+struct PagedCourse {
+    std::string number;
+    std::string title;
+    std::vector<std::string> prereqs;
+};
+
+class PagedCatalog {
+public:
+    // Opens a file written by PagedCatalogBuilder. `source` names the CSV it must
+    // be current with; when empty it is set to the path recorded in the file,
+    // so a caller can rebuild from it.
+    bool open(const std::string& path, size_t poolPages, std::string& source, std::string& outError) {
+        path_ = path;
+        PagedHeader h{};
+        std::string recorded;
+        FileStamp self;
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (!in.is_open() || !statFile(path, self)) {
+                outError = "Paged catalog \"" + path + "\" could not be opened.";
+                return false;
+            }
+            std::vector<char> page(kPageSize);
+            const bool read = static_cast<bool>(in.read(page.data(), static_cast<std::streamsize>(kPageSize)));
+            if (read) std::memcpy(&h, page.data(), sizeof h);
+            if (!read || std::memcmp(h.magic, kPagedMagic, sizeof h.magic) != 0 || h.version != kPagedVersion ||
+                h.byteOrder != kSnapshotByteOrder || h.pageSize != kPageSize || h.height == 0 || h.height > 64 ||
+                h.rootPage == 0 || h.rootPage >= h.pageCount || h.sourcePathLength > kPageSize - sizeof h ||
+                self.size != uint64_t{h.pageCount} * kPageSize) {
+                outError = "Paged catalog \"" + path + "\" is not valid.";
+                return false;
+            }
+            recorded.assign(page.data() + sizeof h, h.sourcePathLength);
+        }
+        if (source.empty()) source = recorded;
+        FileStamp current;
+        if (!statFile(source, current) || current != FileStamp{h.sourceSize, h.sourceMtimeNs}) {
+            outError = "Paged catalog \"" + path + "\" is out of date.";
+            return false;
+        }
+        if (!pool_.open(path, poolPages)) {
+            outError = "Paged catalog \"" + path + "\" could not be opened.";
+            return false;
+        }
+        header_ = h;
+        failed_ = false;
+        return true;
+    }
+
+    uint64_t size() const { return header_.courseCount; }
+    uint32_t height() const { return header_.height; }
+    uint32_t pageCount() const { return header_.pageCount; }
+    BufferPool::Stats poolStats() const { return pool_.stats(); }
+
+    // Set once a page turned out unreadable or malformed; queries then find nothing.
+    bool failed() const { return failed_; }
+    std::string failure() const { return "Error: paged catalog \"" + path_ + "\" is damaged or unreadable."; }
+
+    bool find(std::string_view number, PagedCourse& out) {
+        bool found = false;
+        scanFrom(number, [&](const PagedRecord& r) {
+            if (r.number == number) {
+                found = true;
+                out.number.assign(r.number);
+                out.title.assign(r.title);
+                out.prereqs.clear();
+                r.forEachPrereq([&](std::string_view p) { out.prereqs.emplace_back(p); });
+            }
+            return false;
+        });
+        return found;
+    }
+
+    // Visits records with number >= `from` in order until `fn` returns false.
+    // A record's views are only valid during its call, and `fn` must not query
+    // this catalog.
+    template <typename Fn>
+    void scanFrom(std::string_view from, Fn&& fn) {
+        if (failed_) return;
+        uint32_t page = leafFor(CourseKey::from(from));
+        bool started = false;
+        // A damaged next link could loop; no walk visits more pages than exist.
+        for (uint32_t hops = 0; page && hops < header_.pageCount; ++hops) {
+            const char* p = pool_.fetch(page);
+            PageHead h;
+            if (!p || !readHead(p, kLeafPage, h)) return fail();
+            size_t i = 0;
+            if (!started) {
+                // Long keys can tie across a page boundary, so the first
+                // record >= from may still be further right.
+                size_t lo = 0, hi = h.count;
+                while (lo < hi) {
+                    const size_t mid = lo + (hi - lo) / 2;
+                    PagedRecord r;
+                    if (!record(p, h, mid, r)) return fail();
+                    if (r.number < from) lo = mid + 1;
+                    else hi = mid;
+                }
+                i = lo;
+                started = i < h.count;
+            }
+            for (; i < h.count; ++i) {
+                PagedRecord r;
+                if (!record(p, h, i, r)) return fail();
+                if (!fn(r)) return;
+            }
+            page = h.next;
+        }
+    }
+
+private:
+    std::string path_;
+    PagedHeader header_{};
+    BufferPool pool_;
+    bool failed_{false};
+
+    void fail() { failed_ = true; }
+
+    bool readHead(const char* page, uint16_t type, PageHead& h) const {
+        std::memcpy(&h, page, sizeof h);
+        if (h.type != type || h.next >= header_.pageCount) return false;
+        if (type == kInternalPage) return h.count > 0 && h.count <= kInternalFanout;
+        return sizeof h + size_t{h.count} * 2 <= kPageSize;
+    }
+
+    bool record(const char* page, const PageHead& h, size_t i, PagedRecord& out) const {
+        const size_t at = getU16(page + sizeof h + 2 * i);
+        if (at < sizeof h + size_t{h.count} * 2 || at >= kPageSize) return false;
+        return decodePagedRecord(std::string_view(page + at, kPageSize - at), out);
+    }
+
+    // Leaf to start a lower-bound walk for `key` from; 0 after a failure.
+    uint32_t leafFor(const CourseKey& key) {
+        uint32_t page = header_.rootPage;
+        for (uint32_t level = header_.height; level > 1; --level) {
+            const char* p = pool_.fetch(page);
+            PageHead h;
+            if (!p || !readHead(p, kInternalPage, h)) {
+                fail();
+                return 0;
+            }
+            // Last child whose first key is below `key`, or equal to it when
+            // equal keys mean equal numbers.
+            auto entry = [&](size_t i, CourseKey& k, uint32_t& child) {
+                const char* e = p + sizeof h + i * kInternalEntry;
+                std::memcpy(&k, e, sizeof k);
+                std::memcpy(&child, e + sizeof k, sizeof child);
+            };
+            size_t lo = 1, hi = h.count;
+            while (lo < hi) {
+                const size_t mid = lo + (hi - lo) / 2;
+                CourseKey k;
+                uint32_t child;
+                entry(mid, k, child);
+                if (k < key || (k == key && key.packed())) lo = mid + 1;
+                else hi = mid;
+            }
+            CourseKey k;
+            entry(lo - 1, k, page);
+            if (page == 0 || page >= header_.pageCount) {
+                fail();
+                return 0;
+            }
+        }
+        return page;
+    }
+};
+
+// Writes pages of a new paged catalog in one pass over records arriving in key
+// order. Page numbers are handed out as pages are started, so a leaf knows its
+// successor's number when it is written, and each level above keeps only the
+// one page it is filling.
+class PagedTreeWriter {
+public:
+    bool open(const std::string& path) {
+        out_.open(path, std::ios::binary | std::ios::trunc);
+        return out_.is_open();
+    }
+
+    bool add(std::string_view record, std::string_view number) {
+        const size_t used = sizeof(PageHead) + 2 * (offsets_.size() + 1) + leaf_.size();
+        if (!offsets_.empty() && used + record.size() > kPageSize) {
+            const uint32_t next = nextPage_++;
+            if (!writeLeaf(next)) return false;
+            leafPage_ = next;
+        } else if (offsets_.empty()) {
+            leafPage_ = nextPage_++;
+        }
+        if (offsets_.empty()) leafFirst_ = CourseKey::from(number);
+        offsets_.push_back(leaf_.size());
+        leaf_.append(record.data(), record.size());
+        ++count_;
+        return true;
+    }
+
+    uint64_t count() const { return count_; }
+
+    // Writes the last pages and the header (recording `source` and its stamp).
+    bool finish(const std::string& source, const FileStamp& stamp, uint32_t& height) {
+        if (offsets_.empty() || source.size() > kPageSize - sizeof(PagedHeader)) return false;
+        uint32_t root = leafPage_;
+        height = 1;
+        if (levels_.empty()) {
+            // Everything fit in one leaf, which is then the root.
+            if (!writeLeaf(0, false)) return false;
+        } else {
+            if (!writeLeaf(0)) return false;
+            for (size_t i = 0;; ++i) {
+                if (i + 1 == levels_.size() && levels_[i].flushed == 0) {
+                    root = levels_[i].page;
+                    height = static_cast<uint32_t>(i + 2);
+                    if (!writeInternal(i, false)) return false;
+                    break;
+                }
+                if (!writeInternal(i, true)) return false;
+            }
+        }
+
+        PagedHeader h{};
+        std::memcpy(h.magic, kPagedMagic, sizeof h.magic);
+        h.version = kPagedVersion;
+        h.byteOrder = kSnapshotByteOrder;
+        h.pageSize = kPageSize;
+        h.height = height;
+        h.rootPage = root;
+        h.pageCount = nextPage_;
+        h.courseCount = count_;
+        h.sourceSize = stamp.size;
+        h.sourceMtimeNs = stamp.mtimeNs;
+        h.sourcePathLength = static_cast<uint32_t>(source.size());
+        std::string page(kPageSize, '\0');
+        std::memcpy(&page[0], &h, sizeof h);
+        std::memcpy(&page[sizeof h], source.data(), source.size());
+        return writePage(0, page) && static_cast<bool>(out_.flush());
+    }
+
+private:
+    struct Level {
+        uint32_t page{0};
+        CourseKey first;
+        std::string entries;
+        size_t count{0};
+        size_t flushed{0}; // pages already written at this level
+    };
+
+    std::ofstream out_;
+    uint32_t nextPage_{1}; // page 0 is the header
+    uint64_t count_{0};
+    uint32_t leafPage_{0};
+    CourseKey leafFirst_;
+    std::string leaf_;
+    std::vector<size_t> offsets_; // into leaf_
+    std::vector<Level> levels_;   // levels_[0] sits just above the leaves
+
+    bool writePage(uint32_t page, std::string& bytes) {
+        bytes.resize(kPageSize, '\0');
+        out_.seekp(static_cast<std::streamoff>(uint64_t{page} * kPageSize));
+        return static_cast<bool>(out_.write(bytes.data(), static_cast<std::streamsize>(kPageSize)));
+    }
+
+    bool writeLeaf(uint32_t next, bool link = true) {
+        const PageHead h{kLeafPage, static_cast<uint16_t>(offsets_.size()), next};
+        std::string page(reinterpret_cast<const char*>(&h), sizeof h);
+        const size_t base = sizeof h + 2 * offsets_.size();
+        for (size_t at : offsets_) putU16(page, base + at);
+        page.append(leaf_);
+        if (!writePage(leafPage_, page)) return false;
+        leaf_.clear();
+        offsets_.clear();
+        return !link || push(0, leafFirst_, leafPage_);
+    }
+
+    // Adds a child to the page being filled at `level`, writing that page
+    // first if it is full.
+    bool push(size_t level, const CourseKey& key, uint32_t child) {
+        if (level == levels_.size()) levels_.emplace_back();
+        if (levels_[level].count == kInternalFanout && !writeInternal(level, true)) return false;
+        Level& l = levels_[level];
+        if (l.count == 0) {
+            l.page = nextPage_++;
+            l.first = key;
+        }
+        l.entries.append(reinterpret_cast<const char*>(&key), sizeof key);
+        l.entries.append(reinterpret_cast<const char*>(&child), sizeof child);
+        ++l.count;
+        return true;
+    }
+
+    bool writeInternal(size_t level, bool link) {
+        Level& l = levels_[level];
+        const PageHead h{kInternalPage, static_cast<uint16_t>(l.count), 0};
+        std::string page(reinterpret_cast<const char*>(&h), sizeof h);
+        page.append(l.entries);
+        if (!writePage(l.page, page)) return false;
+        const CourseKey first = l.first;
+        const uint32_t written = l.page;
+        l.entries.clear();
+        l.count = 0;
+        ++l.flushed;
+        return !link || push(level + 1, first, written);
+    }
+};
+
+// Builds a paged catalog at `path` from `csvPath`, holding at most about
+// kSortBudget bytes of rows at once. Malformed lines are warned about and
+// skipped as in a normal load. Returns false with `outError` set on failure.
+class PagedCatalogBuilder {
+public:
+    static constexpr size_t kReadBlock = 4 << 20;
+    static constexpr size_t kSortBudget = 32 << 20;
+    static constexpr size_t kMergeFanIn = 64;
+
+    bool build(const std::string& csvPath, const std::string& path, std::ostream& log, std::string& outError) {
+        path_ = path;
+        FileStamp stamp;
+        std::ifstream in(csvPath, std::ios::binary);
+        if (!in.is_open() || !statFile(csvPath, stamp)) {
+            outError = "Error: Could not open file \"" + csvPath + "\".";
+            return false;
+        }
+
+        // Read line-aligned blocks; a partial last line waits for the next one.
+        std::string block;
+        bool more = true;
+        while (more) {
+            const size_t carry = block.size();
+            block.resize(carry + kReadBlock);
+            in.read(&block[carry], static_cast<std::streamsize>(kReadBlock));
+            block.resize(carry + static_cast<size_t>(in.gcount()));
+            more = static_cast<bool>(in);
+            size_t end = block.size();
+            if (more) {
+                end = block.rfind('\n');
+                if (end == std::string::npos) continue; // one line longer than a block
+                ++end;
+            }
+            std::vector<ParsedChunk> chunks;
+            parseChunks(std::string_view(block).substr(0, end), chunks);
+            for (const ParsedChunk& chunk : chunks) {
+                if (!stage(chunk, outError)) return false;
+            }
+            block.erase(0, end);
+        }
+        if (in.bad()) {
+            outError = "Error: Could not read file \"" + csvPath + "\".";
+            return false;
+        }
+        if (rows_ == 0) {
+            outError = "Error: No valid course records were loaded from the file.";
+            return false;
+        }
+        if (!spill(outError)) return false;
+        const size_t runCount = runs_.size();
+
+        // Merge in passes of at most kMergeFanIn runs until one pass can
+        // feed the tree writer directly.
+        while (runs_.size() > kMergeFanIn) {
+            std::vector<std::string> merged;
+            for (size_t i = 0; i < runs_.size(); i += kMergeFanIn) {
+                const std::vector<std::string> group(runs_.begin() + static_cast<std::ptrdiff_t>(i),
+                                                     runs_.begin() + static_cast<std::ptrdiff_t>(
+                                                         std::min(runs_.size(), i + kMergeFanIn)));
+                merged.push_back(runPath(nextRun_++));
+                temps_.push_back(merged.back());
+                std::ofstream out(merged.back(), std::ios::binary | std::ios::trunc);
+                bool ok = out.is_open() && merge(group, [&](uint64_t seq, const std::string& rec) {
+                    return writeRunRecord(out, seq, rec);
+                });
+                if (!ok || !out.flush()) {
+                    outError = "Error: Could not write \"" + merged.back() + "\".";
+                    return false;
+                }
+                for (const std::string& r : group) std::remove(r.c_str());
+            }
+            runs_ = std::move(merged);
+        }
+
+        const std::string tmp = path + ".tmp";
+        temps_.push_back(tmp);
+        PagedTreeWriter tree;
+        uint32_t height = 0;
+        bool ok = tree.open(tmp) &&
+                  merge(runs_, [&](uint64_t, const std::string& rec) {
+                      PagedRecord r;
+                      return decodePagedRecord(rec, r) && tree.add(rec, r.number);
+                  }) &&
+                  tree.finish(csvPath, stamp, height);
+        if (!ok) {
+            outError = "Error: Could not write paged catalog \"" + path + "\".";
+            return false;
+        }
+#ifndef ADVISING_HAVE_MMAP
+        std::remove(path.c_str()); // rename() does not replace files everywhere
+#endif
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            outError = "Error: Could not replace paged catalog \"" + path + "\".";
+            return false;
+        }
+        temps_.pop_back();
+
+        log << "Built paged catalog \"" << path << "\": " << tree.count() << " course(s) from " << rows_
+            << " row(s) in " << runCount << " sorted run(s), " << height << " level(s)";
+        if (skipped_) log << " (" << skipped_ << " line(s) skipped for format issues)";
+        log << ".\n";
+        return true;
+    }
+
+    ~PagedCatalogBuilder() {
+        for (const std::string& t : temps_) std::remove(t.c_str());
+    }
+
+private:
+    // A staged row: its encoded record in bytes_, ordered by key then file order.
+    struct Staged {
+        CourseKey key;
+        uint64_t seq;
+        size_t offset;
+        size_t length;
+    };
+
+    std::string path_;
+    std::string bytes_;
+    std::vector<Staged> staged_;
+    std::vector<std::string> runs_;
+    std::vector<std::string> temps_; // removed when the builder goes away
+    size_t nextRun_{0};
+    uint64_t rows_{0};
+    size_t lineBase_{0};
+    size_t skipped_{0};
+
+    std::string runPath(size_t n) const { return path_ + ".run" + std::to_string(n); }
+
+    static std::string_view recordNumber(std::string_view rec) { return rec.substr(6, getU16(rec.data())); }
+
+    bool stage(const ParsedChunk& chunk, std::string& outError) {
+        for (const ParsedRow& r : chunk.rows) {
+            const size_t offset = bytes_.size();
+            if (!encodePagedRecord(r.number, r.title, chunk.prereqs.data() + r.firstPrereq, r.prereqCount, bytes_)) {
+                std::cerr << "Warning (line " << lineBase_ + r.line
+                          << "): record too large for a catalog page. Skipping line.\n";
+                ++skipped_;
+                continue;
+            }
+            staged_.push_back({CourseKey::from(r.number), rows_++, offset, bytes_.size() - offset});
+            if (bytes_.size() + staged_.size() * sizeof(Staged) >= kSortBudget && !spill(outError)) return false;
+        }
+        for (size_t bad : chunk.badLines) {
+            std::cerr << "Warning (line " << lineBase_ + bad
+                      << "): expected at least course number and title. Skipping line.\n";
+            ++skipped_;
+        }
+        lineBase_ += chunk.lines;
+        return true;
+    }
+
+    // Sorts the staged rows into a new run file and empties the buffer.
+    bool spill(std::string& outError) {
+        if (staged_.empty()) return true;
+        std::sort(staged_.begin(), staged_.end(), [&](const Staged& a, const Staged& b) {
+            const std::string_view an = recordNumber(std::string_view(bytes_).substr(a.offset, a.length));
+            const std::string_view bn = recordNumber(std::string_view(bytes_).substr(b.offset, b.length));
+            if (numberLess(a.key, an, b.key, bn)) return true;
+            if (numberLess(b.key, bn, a.key, an)) return false;
+            return a.seq < b.seq;
+        });
+        runs_.push_back(runPath(nextRun_++));
+        temps_.push_back(runs_.back());
+        std::ofstream out(runs_.back(), std::ios::binary | std::ios::trunc);
+        std::string rec;
+        for (const Staged& s : staged_) {
+            rec.assign(bytes_, s.offset, s.length);
+            if (!writeRunRecord(out, s.seq, rec)) break;
+        }
+        if (!out.flush()) {
+            outError = "Error: Could not write \"" + runs_.back() + "\".";
+            return false;
+        }
+        staged_.clear();
+        bytes_.clear();
+        return true;
+    }
+
+    static bool writeRunRecord(std::ostream& out, uint64_t seq, const std::string& rec) {
+        const uint32_t length = static_cast<uint32_t>(rec.size());
+        out.write(reinterpret_cast<const char*>(&seq), sizeof seq);
+        out.write(reinterpret_cast<const char*>(&length), sizeof length);
+        out.write(rec.data(), static_cast<std::streamsize>(rec.size()));
+        return static_cast<bool>(out);
+    }
+
+    // Sequential reader over one run file with its own read buffer.
+    struct RunReader {
+        std::ifstream in;
+        std::vector<char> buffer;
+        uint64_t seq{0};
+        std::string rec;
+        CourseKey key;
+
+        bool open(const std::string& path) {
+            buffer.resize(64 * 1024);
+            in.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            in.open(path, std::ios::binary);
+            return in.is_open();
+        }
+
+        bool next() {
+            uint32_t length = 0;
+            if (!in.read(reinterpret_cast<char*>(&seq), sizeof seq)) return false;
+            if (!in.read(reinterpret_cast<char*>(&length), sizeof length) || length < 6) return false;
+            rec.resize(length);
+            if (!in.read(&rec[0], length)) return false;
+            key = CourseKey::from(number());
+            return true;
+        }
+
+        std::string_view number() const { return recordNumber(rec); }
+    };
+
+    // K-way merges `runs`, passing `sink` the last row (highest seq) for each
+    // course number in key order.
+    template <typename Sink>
+    static bool merge(const std::vector<std::string>& runs, Sink&& sink) {
+        std::vector<std::unique_ptr<RunReader>> readers;
+        for (const std::string& r : runs) {
+            readers.push_back(std::make_unique<RunReader>());
+            if (!readers.back()->open(r)) return false;
+        }
+        auto after = [&](size_t a, size_t b) { // heap order: smallest number, then lowest seq, on top
+            const RunReader& x = *readers[a];
+            const RunReader& y = *readers[b];
+            if (numberLess(y.key, y.number(), x.key, x.number())) return true;
+            if (numberLess(x.key, x.number(), y.key, y.number())) return false;
+            return x.seq > y.seq;
+        };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(after)> heap(after);
+        for (size_t i = 0; i < readers.size(); ++i) {
+            if (readers[i]->next()) heap.push(i);
+        }
+
+        std::string pending;
+        uint64_t pendingSeq = 0;
+        while (!heap.empty()) {
+            const size_t i = heap.top();
+            heap.pop();
+            RunReader& r = *readers[i];
+            if (!pending.empty() && recordNumber(pending) != r.number()) {
+                if (!sink(pendingSeq, pending)) return false;
+            }
+            pending.swap(r.rec);
+            pendingSeq = r.seq;
+            if (r.next()) heap.push(i);
+        }
+        return pending.empty() || sink(pendingSeq, pending);
+    }
+};
+
+// ---------- Menu / UI loop ----------
+
+static void printMenu() {
+    std::cout << "================= ABCU Advising Assistance =================\n";
+    std::cout << "1. Load data structure from file\n";
+    std::cout << "2. Print an alphanumeric list of all courses\n";
+    std::cout << "3. Print course information (title and prerequisites)\n";
+    std::cout << "4. Save catalog snapshot to file\n";
+    std::cout << "5. Reload and report changes\n";
+    std::cout << "6. Print every prerequisite a course requires (full chain)\n";
+    std::cout << "7. Plan terms for target courses\n";
+    std::cout << "8. Print courses by prefix or number range\n";
+    std::cout << "9. Exit\n";
+    std::cout << "10. Search course titles\n";
+    std::cout << "11. Print runtime statistics\n";
+    std::cout << "12. Load a named term catalog from file\n";
+    std::cout << "13. Switch to a loaded term\n";
+    std::cout << "14. Compare two terms\n";
+    std::cout << "15. Cancel the load in progress\n";
+    std::cout << "16. Print the courses that depend on a course\n";
+    std::cout << "=============================================================\n";
+    std::cout << "Enter your choice (1-16): ";
+}
+
+// Splits a line of course numbers separated by commas and/or spaces, uppercased.
+static std::vector<std::string> splitCourseList(const std::string& line) {
+    std::vector<std::string> out;
+    std::string cur;
+    for (char ch : line + " ") {
+        if (ch == ',' || std::isspace(static_cast<unsigned char>(ch))) {
+            if (!cur.empty()) out.push_back(cur);
+            cur.clear();
+        } else {
+            cur.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(ch))));
+        }
+    }
+    return out;
+}
+
+// Whether stdin is a terminal. Scripted sessions load in the foreground, so
+// every answer still follows the command that produced it.
+static bool interactiveInput() {
+#if defined(__unix__) || defined(__APPLE__)
+    return isatty(STDIN_FILENO) != 0;
+#else
+    return false;
+#endif
+}
+
+// Menu option 1 on a worker thread, so the menu keeps answering from the
+// published catalog while a big file loads. Until the worker is joined it owns
+// the job's messages and result; the menu thread only reads the progress
+// counters, and shows them each time the menu is printed.
+class BackgroundLoad {
+public:
+    BackgroundLoad() = default;
+    BackgroundLoad(const BackgroundLoad&) = delete;
+    BackgroundLoad& operator=(const BackgroundLoad&) = delete;
+    ~BackgroundLoad() {
+        cancel();
+        if (worker_.joinable()) worker_.join();
+    }
+
+    bool running() const { return worker_.joinable(); }
+
+    // False if no thread could be started; the caller then loads in place.
+    bool start(CoursePlanner& planner, const std::string& filename) {
+        progress_ = std::make_unique<LoadProgress>();
+        progress_->messages = &messages_;
+        messages_.str("");
+        filename_ = filename;
+        error_.clear();
+        done_.store(false, std::memory_order_relaxed);
+        started_ = std::chrono::steady_clock::now();
+        try {
+            worker_ = std::thread([this, &planner] {
+                try {
+                    ok_ = planner.loadFromFile(filename_, error_, progress_.get());
+                } catch (const std::bad_alloc&) {
+                    ok_ = false;
+                    error_ = "Error: not enough memory to load \"" + filename_ + "\".";
+                }
+                finished_ = std::chrono::steady_clock::now();
+                done_.store(true, std::memory_order_release);
+            });
+        } catch (const std::system_error&) {
+            return false;
+        }
+        return true;
+    }
+
+    void cancel() {
+        if (running()) progress_->cancel.store(true, std::memory_order_relaxed);
+    }
+
+    // A finished load is joined and its messages and result printed; one still
+    // running gets a progress line. Prints nothing when no load was started.
+    void report(std::ostream& out) {
+        if (!running()) return;
+        if (done_.load(std::memory_order_acquire)) {
+            finish(out);
+            return;
+        }
+        const LoadProgress& p = *progress_;
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(1) << "Loading \"" << filename_ << "\" ("
+             << PlannerStats::kPhaseNames[p.phase.load(std::memory_order_relaxed)] << "): "
+             << mebibytes(p.bytesParsed.load(std::memory_order_relaxed)) << " of "
+             << mebibytes(p.bytesTotal.load(std::memory_order_relaxed)) << " MiB, "
+             << p.rows.load(std::memory_order_relaxed) << " rows; " << rates() << ". Option 15 cancels.\n";
+        out << line.str();
+    }
+
+    // Waits for the load and prints how it ended.
+    void finish(std::ostream& out) {
+        if (!running()) return;
+        worker_.join();
+        out << messages_.str();
+        if (!ok_) {
+            out << error_ << "\n\n";
+            return;
+        }
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(2) << "File \"" << filename_ << "\" loaded successfully in "
+             << seconds() << " s (" << std::setprecision(1) << rates() << ").\n\n";
+        out << line.str();
+    }
+
+private:
+    std::thread worker_;
+    std::unique_ptr<LoadProgress> progress_;
+    std::atomic<bool> done_{false};
+    std::ostringstream messages_;
+    std::string filename_;
+    std::string error_;
+    bool ok_{false};
+    std::chrono::steady_clock::time_point started_;
+    std::chrono::steady_clock::time_point finished_; // set by the worker before done_
+
+    static double mebibytes(uint64_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); }
+
+    double seconds() const {
+        const auto end = done_.load(std::memory_order_acquire) ? finished_ : std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - started_).count();
+    }
+
+    // "N MiB/s, N rows/s" since the load started.
+    std::string rates() const {
+        const double s = std::max(seconds(), 1e-6);
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(1)
+            << mebibytes(progress_->bytesParsed.load(std::memory_order_relaxed)) / s << " MiB/s, "
+            << std::setprecision(0) << static_cast<double>(progress_->rows.load(std::memory_order_relaxed)) / s
+            << " rows/s";
+        return out.str();
+    }
+};
+
+// Serves the catalog from `snapshotPath` when it is current, otherwise loads the
+// CSV and refreshes the snapshot so the next start can skip parsing.
+static void loadAtStartup(CoursePlanner& planner, const std::string& snapshotPath, std::string csvPath,
+                          std::ostream& log) {
+    std::string err;
+    if (planner.loadSnapshot(snapshotPath, csvPath, err)) {
+        log << "\n";
+        return;
+    }
+    log << err << "\n";
+    if (csvPath.empty()) {
+        log << "No course data file to fall back to; use Option 1.\n\n";
+        return;
+    }
+
+    log << "Loading \"" << csvPath << "\" instead.\n";
+    if (!planner.loadFromFile(csvPath, err)) {
+        log << err << "\n\n";
+        return;
+    }
+    if (planner.saveSnapshot(snapshotPath, err)) {
+        log << "Snapshot \"" << snapshotPath << "\" refreshed.\n";
+    } else {
+        log << err << "\n";
+    }
+    log << "\n";
+}
+
+// ---------- Batch queries ----------
+//
+// runBatch parses the query lines; a QueryBackend answers them. The planner
+// and the paged catalog each adapt their own lookups to it and format what they
+// find with the shared answer formatting above.
+
+class QueryBackend {
+public:
+    virtual ~QueryBackend() = default;
+
+    // Course details; `number` is as typed. In JSON, misses carry suggestions
+    // where the backend has them.
+    virtual void info(const std::string& number, bool json, std::ostream& out) = 0;
+    virtual void lookup(std::vector<std::string> numbers, bool json, std::ostream& out) = 0;
+    virtual void list(bool json, std::ostream& out) = 0;
+    // With `hi` empty, every course whose number starts with `lo`.
+    virtual void range(const std::string& lo, const std::string& hi, bool json, std::ostream& out) = 0;
+    virtual void stats(std::ostream& out) = 0;
+
+    // These need the whole catalog in memory; a backend without it refuses them.
+    virtual void chain(const std::string&, bool, std::ostream& out) { refuse("chain", out); }
+    virtual void dependents(const std::string&, bool, std::ostream& out) { refuse("dependents", out); }
+    virtual void search(const std::string&, bool, std::ostream& out) { refuse("search", out); }
+    virtual void cache(bool, std::ostream& out) { refuse("cache", out); }
+    virtual void term(const std::string&, std::ostream& out) { refuse("term", out); }
+    virtual void terms(std::ostream& out) { refuse("terms", out); }
+    virtual void diff(const std::string&, const std::string&, std::ostream& out) { refuse("diff", out); }
+
+    // Set once the backend can answer nothing more; the batch stops there.
+    virtual bool failed() const { return false; }
+
+protected:
+    virtual void refuse(std::string_view cmd, std::ostream& out) {
+        out << "Error: \"" << cmd << "\" is not available.\n";
+    }
+};
+
+// Answers one query per line without the menu. A line is a course number
+// (details as in Option 3), or one of:
+//   info NUMBER    course details
+//   chain NUMBER   every prerequisite, as in Option 6
+//   dependents NUMBER  courses that need NUMBER, as in Option 16
+//   lookup NUMBER...   title (or "not found") for each number, in one pass
+//   list           the sorted course list, as in Option 2
+//   json NUMBER    course details as one JSON object
+//   ndjson         the sorted course list as NDJSON
+//   prefix TEXT    courses whose number starts with TEXT
+//   range LO HI    courses numbered LO through HI (inclusive)
+//   search WORDS   courses whose titles contain every word (WORD* = prefix)
+//   cache          rendered-response cache hits, misses and occupancy
+//   stats          load timers, latency histograms and gauges (Prometheus text)
+//   term NAME      answer later queries from the loaded term NAME
+//   terms          the loaded terms
+//   diff FROM TO   courses added, changed or removed from term FROM to term TO
+// With `json` set, bare numbers, `info`, `chain`, `dependents`, `lookup`, `list`,
+// `prefix`, `range` and `search` answer in the JSON forms.
+// Blank lines and lines starting with '#' are ignored.
+static void runBatch(QueryBackend& backend, std::istream& in, std::ostream& out, bool json) {
+    std::string line;
+    while (!backend.failed() && std::getline(in, line)) {
+        std::string_view q = trimView(line);
+        if (q.empty() || q[0] == '#') continue;
+
+        size_t space = q.find_first_of(" \t");
+        std::string_view cmd = q.substr(0, space);
+        std::string arg(space == std::string_view::npos ? std::string_view{} : trimView(q.substr(space)));
+
+        if (cmd == "info" || cmd == "json") {
+            backend.info(arg, json || cmd == "json", out);
+        } else if (cmd == "chain") {
+            backend.chain(arg, json, out);
+        } else if (cmd == "dependents") {
+            backend.dependents(arg, json, out);
+        } else if (cmd == "lookup") {
+            std::vector<std::string> numbers = splitCourseList(arg);
+            if (numbers.empty()) {
+                out << "Error: usage is \"lookup NUMBER...\".\n";
+                continue;
+            }
+            backend.lookup(std::move(numbers), json, out);
+        } else if ((cmd == "list" || cmd == "ndjson") && arg.empty()) {
+            backend.list(json || cmd == "ndjson", out);
+        } else if (cmd == "stats" && arg.empty()) {
+            backend.stats(out);
+        } else if (cmd == "cache" && arg.empty()) {
+            backend.cache(json, out);
+        } else if (cmd == "term" && !arg.empty()) {
+            backend.term(arg, out);
+        } else if (cmd == "terms" && arg.empty()) {
+            backend.terms(out);
+        } else if (cmd == "diff") {
+            std::istringstream names(arg);
+            std::string from, to, extra;
+            if (!(names >> from >> to) || names >> extra) {
+                out << "Error: usage is \"diff FROM TO\".\n";
+                continue;
+            }
+            backend.diff(from, to, out);
+        } else if (cmd == "search") {
+            backend.search(arg, json, out);
+        } else if (cmd == "prefix" || cmd == "range") {
+            std::vector<std::string> bounds = splitCourseList(arg);
+            if (bounds.size() != (cmd == "range" ? 2u : 1u)) {
+                out << "Error: usage is \"prefix TEXT\" or \"range LO HI\".\n";
+                continue;
+            }
+            backend.range(bounds[0], bounds.size() == 2 ? bounds[1] : std::string(), json, out);
+        } else {
+            backend.info(std::string(q), json, out);
+        }
+    }
+    out.flush();
+}
+
+// The loaded catalog, answering through the planner.
+class PlannerQueries : public QueryBackend {
+public:
+    explicit PlannerQueries(CoursePlanner& planner) : planner_(planner) {}
+
+    void info(const std::string& number, bool json, std::ostream& out) override {
+        if (json) {
+            planner_.writeCourseJson(number, out);
+        } else {
+            planner_.printCourseInfo(number, out);
+        }
+    }
+
+    void lookup(std::vector<std::string> numbers, bool json, std::ostream& out) override {
+        if (json) {
+            planner_.writeCourseLookupNdjson(std::move(numbers), out);
+        } else {
+            planner_.printCourseLookup(std::move(numbers), out);
+        }
+    }
+
+    void list(bool json, std::ostream& out) override {
+        if (json) {
+            planner_.writeCourseListNdjson(out);
+        } else {
+            planner_.printCourseList(out);
+        }
+    }
+
+    void range(const std::string& lo, const std::string& hi, bool json, std::ostream& out) override {
+        if (json) {
+            planner_.writeCourseRangeNdjson(lo, hi, out);
+        } else {
+            planner_.printCourseRange(lo, hi, out);
+        }
+    }
+
+    void stats(std::ostream& out) override { planner_.writeStats(out); }
+
+    void chain(const std::string& number, bool json, std::ostream& out) override {
+        if (json) {
+            planner_.writePrereqChainJson(number, out);
+        } else {
+            planner_.printPrereqChain(number, out);
+        }
+    }
+
+    void dependents(const std::string& number, bool json, std::ostream& out) override {
+        if (json) {
+            planner_.writeDependentsJson(number, out);
+        } else {
+            planner_.printDependents(number, out);
+        }
+    }
+
+    void search(const std::string& words, bool json, std::ostream& out) override {
+        if (json) {
+            planner_.writeTitleSearchNdjson(words, out);
+        } else {
+            planner_.printTitleSearch(words, out);
+        }
+    }
+
+    void cache(bool json, std::ostream& out) override {
+        const ResponseCache::Stats st = planner_.responseCacheStats();
+        if (json) {
+            out << "{\"hits\":" << st.hits << ",\"misses\":" << st.misses << ",\"entries\":" << st.entries
+                << ",\"capacity\":" << st.capacity << "}\n";
+        } else {
+            out << "Response cache: " << st.hits << " hit(s), " << st.misses << " miss(es), " << st.entries
+                << " of " << st.capacity << " entries used.\n";
+        }
+    }
+
+    void term(const std::string& name, std::ostream& out) override {
+        std::string err;
+        if (!planner_.useTerm(name, err)) out << err << "\n";
+    }
+
+    void terms(std::ostream& out) override { planner_.printTerms(out); }
+
+    void diff(const std::string& from, const std::string& to, std::ostream& out) override {
+        planner_.printTermDiff(from, to, out);
+    }
+
+private:
+    CoursePlanner& planner_;
+};
+
+// A paged catalog (--paged). Answers look as they do from the planner, except
+// that misses carry no suggestions and cycles are neither noted nor flagged
+// (JSON objects leave out "inCycle"). `stats` reports the buffer pool, and the
+// commands that need the whole catalog in memory are refused. Stops at the
+// first damaged page.
+class PagedQueries : public QueryBackend {
+public:
+    explicit PagedQueries(PagedCatalog& cat) : cat_(cat) {}
+
+    void info(const std::string& raw, bool json, std::ostream& out) override {
+        std::string number(trimView(raw));
+        toUpperInPlace(number);
+        std::string buf;
+        if (json) {
+            buf.append("{\"number\":");
+            appendJsonString(buf, number);
+            if (number.empty()) {
+                buf.append(",\"error\":\"empty course number\"}\n");
+            } else if (!cat_.find(number, c_)) {
+                appendJsonMiss(buf, {});
+            } else {
+                buf.append(",\"title\":");
+                appendJsonString(buf, c_.title);
+                buf.append(",\"prereqs\":[");
+                for (size_t i = 0; i < c_.prereqs.size(); ++i) {
+                    if (i) buf.push_back(',');
+                    const bool defined = cat_.find(c_.prereqs[i], p_);
+                    appendJsonPrereq(buf, c_.prereqs[i], p_.title, defined);
+                }
+                buf.append("]}\n");
+            }
+        } else if (number.empty()) {
+            buf.append("Error: course number cannot be empty.\n");
+        } else if (!cat_.find(number, c_)) {
+            appendNotFound(buf, number, {});
+        } else {
+            appendCourseHeading(buf, c_.number, c_.title);
+            if (c_.prereqs.empty()) {
+                buf.append("Prerequisites: None\n\n");
+            } else {
+                buf.append("Prerequisites:\n");
+                for (const std::string& prereq : c_.prereqs) {
+                    const bool defined = cat_.find(prereq, p_);
+                    appendPrereqLine(buf, prereq, p_.title, defined);
+                }
+                buf.push_back('\n');
+            }
+        }
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+
+    void lookup(std::vector<std::string> numbers, bool json, std::ostream& out) override {
+        std::string buf;
+        size_t hits = 0;
+        for (std::string& n : numbers) {
+            n = trimCopy(n);
+            toUpperInPlace(n);
+            const bool found = cat_.find(n, c_);
+            hits += found;
+            if (json) {
+                if (found) {
+                    appendNdjson(buf, c_);
+                } else {
+                    appendLookupMissNdjson(buf, n);
+                }
+            } else if (found) {
+                appendListLine(buf, c_.number, c_.title);
+            } else {
+                buf.append(n).append(" (not found)\n");
+            }
+        }
+        if (!json) appendLookupTotal(buf, hits, numbers.size());
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+
+    void list(bool json, std::ostream& out) override {
+        if (!json) {
+            std::string heading;
+            appendListHeading(heading, kCourseListHeading);
+            out << heading;
+        }
+        listing({}, json, [](std::string_view) { return true; }, out);
+    }
+
+    void range(const std::string& rawLo, const std::string& rawHi, bool json, std::ostream& out) override {
+        std::string lo, hi;
+        if (!normalizeRange(rawLo, rawHi, lo, hi)) {
+            out << (json ? "{\"error\":\"empty course number\"}\n" : "Error: course number cannot be empty.\n");
+            return;
+        }
+        if (!json) {
+            std::string heading;
+            appendListHeading(heading, rangeHeading(lo, hi));
+            out << heading;
+        }
+        if (hi.empty()) {
+            listing(lo, json, [&](std::string_view n) { return n.substr(0, lo.size()) == lo; }, out);
+        } else {
+            listing(lo, json, [&](std::string_view n) { return n <= hi; }, out);
+        }
+    }
+
+    void stats(std::ostream& out) override {
+        const BufferPool::Stats st = cat_.poolStats();
+        out << "Paged catalog: " << cat_.size() << " course(s), " << cat_.height() << " level(s), "
+            << cat_.pageCount() << " page(s). Buffer pool: " << st.hits << " hit(s), " << st.misses
+            << " miss(es), " << st.resident << " of " << st.capacity << " pages resident.\n";
+    }
+
+    bool failed() const override { return cat_.failed(); }
+
+protected:
+    void refuse(std::string_view cmd, std::ostream& out) override {
+        out << "Error: \"" << cmd << "\" is not available with --paged.\n";
+    }
+
+private:
+    PagedCatalog& cat_;
+    PagedCourse c_, p_; // reused across queries
+
+    static void appendNdjson(std::string& buf, const PagedCourse& c) {
+        appendCourseNdjson(buf, c.number, c.title, [&](auto&& fn) {
+            for (const std::string& p : c.prereqs) fn(p);
+        });
+    }
+
+    // The courses from `from` on while `keep` accepts the number, as listing
+    // lines (closed with the total) or NDJSON, flushed as the buffer fills.
+    template <typename Keep>
+    void listing(std::string_view from, bool json, Keep&& keep, std::ostream& out) {
+        constexpr size_t kFlushBytes = 64 * 1024;
+        std::string buf;
+        size_t count = 0;
+        cat_.scanFrom(from, [&](const PagedRecord& r) {
+            if (!keep(r.number)) return false;
+            if (json) {
+                appendCourseNdjson(buf, r.number, r.title, [&](auto&& fn) { r.forEachPrereq(fn); });
+            } else {
+                appendListLine(buf, r.number, r.title);
+            }
+            ++count;
+            if (buf.size() >= kFlushBytes) {
+                out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+                buf.clear();
+            }
+            return true;
+        });
+        if (!json) appendListTotal(buf, count);
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+};
+
+// --paged: opens the paged catalog, building it from the CSV first when it is
+// missing or out of date, then answers batch queries from it.
+static int runPaged(const std::string& pagedPath, std::string csvPath, size_t poolPages,
+                    const std::string& queriesPath, bool json) {
+    PagedCatalog cat;
+    std::string err;
+    if (cat.open(pagedPath, poolPages, csvPath, err)) {
+        std::cerr << "Opened paged catalog \"" << pagedPath << "\": " << cat.size() << " course(s), " << cat.height()
+                  << " level(s).\n";
+    } else {
+        std::cerr << err << "\n";
+        if (csvPath.empty()) {
+            std::cerr << "No course data file to build it from.\n";
+            return 1;
+        }
+        std::cerr << "Building it from \"" << csvPath << "\".\n";
+        PagedCatalogBuilder builder;
+        if (!builder.build(csvPath, pagedPath, std::cerr, err) || !cat.open(pagedPath, poolPages, csvPath, err)) {
+            std::cerr << err << "\n";
+            return 1;
+        }
+    }
+
+    std::cin.tie(nullptr);
+    PagedQueries backend(cat);
+    if (queriesPath.empty()) {
+        runBatch(backend, std::cin, std::cout, json);
+    } else {
+        std::ifstream queries(queriesPath);
+        if (!queries.is_open()) {
+            std::cerr << "Error: Could not open file \"" << queriesPath << "\".\n";
+            return 1;
+        }
+        runBatch(backend, queries, std::cout, json);
+    }
+    if (cat.failed()) {
+        std::cerr << cat.failure() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// ---------- HTTP query server ----------
+//
+// With --serve PORT the loaded catalog answers read-only HTTP/1.1 queries, so
+// one process can serve every kiosk:
+//   GET /courses                   the sorted list (NDJSON)
+//   GET /courses?prefix=CSCI3      courses whose number starts with CSCI3
+//   GET /courses?from=LO&to=HI     courses numbered LO through HI (inclusive)
+//   GET /courses/NUMBER            one course, as writeCourseJson
+//   GET /courses/NUMBER/chain      every prerequisite, as writePrereqChainJson
+//   GET /courses/NUMBER/dependents courses that need it, as writeDependentsJson
+//   GET /search?q=WORDS            title search (NDJSON)
+//   GET /metrics                   writeStats output (Prometheus text)
+// Each worker thread runs its own non-blocking epoll loop over the shared
+// listening socket (EPOLLEXCLUSIVE wakes one worker per new connection), so a
+// request is read, answered from the current catalog and written without
+// leaving the thread that accepted it. Connections are kept alive and may
+// pipeline requests. SIGHUP reloads the catalog file; SIGINT/SIGTERM stop.
+
+#ifdef ADVISING_HAVE_EPOLL
+
+struct HttpResponse {
+    int status{200};
+    const char* contentType{"application/json"};
+    std::string body;
+};
+
+static const char* httpReason(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 431: return "Request Header Fields Too Large";
+    default: return "Error";
+    }
+}
+
+// Decodes %XX escapes and '+' (space) in a query-string component.
+static std::string urlDecode(std::string_view s) {
+    auto hex = [](char ch) -> int {
+        if (ch >= '0' && ch <= '9') return ch - '0';
+        ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+        return ch >= 'a' && ch <= 'f' ? ch - 'a' + 10 : -1;
+    };
+    std::string out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '+') {
+            out.push_back(' ');
+        } else if (s[i] == '%' && i + 2 < s.size() && hex(s[i + 1]) >= 0 && hex(s[i + 2]) >= 0) {
+            out.push_back(static_cast<char>(hex(s[i + 1]) * 16 + hex(s[i + 2])));
+            i += 2;
+        } else {
+            out.push_back(s[i]);
+        }
+    }
+    return out;
+}
+
+// Finds `key` in a query string such as "from=A&to=B" and decodes its value.
+static bool queryParam(std::string_view query, std::string_view key, std::string& value) {
+    while (!query.empty()) {
+        size_t amp = query.find('&');
+        std::string_view pair = query.substr(0, amp);
+        size_t eq = pair.find('=');
+        if (pair.substr(0, eq) == key) {
+            value = urlDecode(eq == std::string_view::npos ? std::string_view{} : pair.substr(eq + 1));
+            return true;
+        }
+        if (amp == std::string_view::npos) break;
+        query.remove_prefix(amp + 1);
+    }
+    return false;
+}
+
+static void routeHttp(const CoursePlanner& planner, std::string_view target, HttpResponse& res) {
+    const size_t mark = target.find('?');
+    const std::string_view path = target.substr(0, mark);
+    const std::string_view query = mark == std::string_view::npos ? std::string_view{} : target.substr(mark + 1);
+    static constexpr std::string_view kCourses = "/courses/";
+    static constexpr std::string_view kChain = "/chain";
+    static constexpr std::string_view kDependents = "/dependents";
+
+    std::ostringstream out;
+    if (path == "/courses") {
+        std::string prefix, from, to;
+        res.contentType = "application/x-ndjson";
+        if (queryParam(query, "prefix", prefix)) {
+            planner.writeCourseRangeNdjson(prefix, std::string(), out);
+        } else if (queryParam(query, "from", from) && queryParam(query, "to", to)) {
+            planner.writeCourseRangeNdjson(from, to, out);
+        } else if (query.empty()) {
+            planner.writeCourseListNdjson(out);
+        } else {
+            res.status = 400;
+            res.contentType = "application/json";
+            out << "{\"error\":\"use ?prefix=TEXT or ?from=LO&to=HI\"}\n";
+        }
+    } else if (path.substr(0, kCourses.size()) == kCourses && path.size() > kCourses.size()) {
+        std::string_view number = path.substr(kCourses.size());
+        auto strip = [&](std::string_view suffix) {
+            if (number.size() <= suffix.size() || number.substr(number.size() - suffix.size()) != suffix) return false;
+            number.remove_suffix(suffix.size());
+            return true;
+        };
+        bool found;
+        if (strip(kChain)) {
+            found = planner.writePrereqChainJson(urlDecode(number), out);
+        } else if (strip(kDependents)) {
+            found = planner.writeDependentsJson(urlDecode(number), out);
+        } else {
+            found = planner.writeCourseJson(urlDecode(number), out);
+        }
+        if (!found) res.status = 404;
+    } else if (path == "/metrics") {
+        res.contentType = "text/plain; version=0.0.4";
+        planner.writeStats(out);
+    } else if (path == "/search") {
+        std::string words;
+        queryParam(query, "q", words);
+        res.contentType = "application/x-ndjson";
+        planner.writeTitleSearchNdjson(words, out);
+    } else {
+        res.status = 404;
+        out << "{\"error\":\"no such endpoint\"}\n";
+    }
+    res.body = out.str();
+}
+
+class HttpServer {
+public:
+    explicit HttpServer(const CoursePlanner& planner) : planner_(planner) {}
+    ~HttpServer() {
+        stop();
+        if (listenFd_ >= 0) ::close(listenFd_);
+        if (stopFd_ >= 0) ::close(stopFd_);
+    }
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    bool listen(uint16_t port, std::string& outError) {
+        listenFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        stopFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (listenFd_ < 0 || stopFd_ < 0) {
+            outError = std::string("Error: Could not create server socket: ") + std::strerror(errno) + ".";
+            return false;
+        }
+        int on = 1;
+        ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(port);
+        if (::bind(listenFd_, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0 ||
+            ::listen(listenFd_, SOMAXCONN) != 0) {
+            outError = "Error: Could not listen on port " + std::to_string(port) + ": " + std::strerror(errno) + ".";
+            return false;
+        }
+        return true;
+    }
+
+    void start(size_t threads) {
+        for (size_t i = 0; i < threads; ++i) workers_.emplace_back([this] { runLoop(); });
+    }
+
+    // Wakes every worker and waits for them; open connections are closed.
+    void stop() {
+        if (workers_.empty()) return;
+        const uint64_t one = 1;
+        ssize_t ignored = ::write(stopFd_, &one, sizeof one); // stays readable, so every loop sees it
+        (void)ignored;
+        for (std::thread& t : workers_) t.join();
+        workers_.clear();
+    }
+
+private:
+    static constexpr size_t kMaxHeaderBytes = 16 * 1024;
+    static constexpr size_t kReadBytes = 16 * 1024;
+
+    struct Connection {
+        std::string in;
+        std::string out;
+        size_t sent{0};
+        bool closeAfterWrite{false};
+        uint32_t interest{EPOLLIN | EPOLLRDHUP}; // events registered with epoll
+    };
+
+    const CoursePlanner& planner_;
+    int listenFd_{-1};
+    int stopFd_{-1};
+    std::vector<std::thread> workers_;
+
+    void runLoop() {
+        const int ep = ::epoll_create1(EPOLL_CLOEXEC);
+        if (ep < 0) return;
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+        ev.data.fd = listenFd_;
+        ::epoll_ctl(ep, EPOLL_CTL_ADD, listenFd_, &ev);
+        ev.events = EPOLLIN;
+        ev.data.fd = stopFd_;
+        ::epoll_ctl(ep, EPOLL_CTL_ADD, stopFd_, &ev);
+
+        std::unordered_map<int, Connection> conns;
+        epoll_event events[64];
+        bool running = true;
+        while (running) {
+            const int n = ::epoll_wait(ep, events, 64, -1);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            for (int i = 0; i < n; ++i) {
+                const int fd = events[i].data.fd;
+                if (fd == stopFd_) {
+                    running = false;
+                } else if (fd == listenFd_) {
+                    acceptAll(ep, conns);
+                } else {
+                    auto it = conns.find(fd);
+                    if (it != conns.end() && !service(ep, fd, events[i].events, it->second)) {
+                        ::close(fd); // also leaves the epoll set
+                        conns.erase(it);
+                    }
+                }
+            }
+        }
+        for (auto& entry : conns) ::close(entry.first);
+        ::close(ep);
+    }
+
+    void acceptAll(int ep, std::unordered_map<int, Connection>& conns) {
+        for (;;) {
+            const int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return; // EAGAIN: another worker took it, or the backlog is empty
+            int on = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on);
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLRDHUP;
+            ev.data.fd = fd;
+            if (::epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev) != 0) {
+                ::close(fd);
+                continue;
+            }
+            conns[fd] = Connection{};
+        }
+    }
+
+    // Reads, answers and writes what it can for one ready connection. Returns
+    // false once the connection should be closed.
+    bool service(int ep, int fd, uint32_t ready, Connection& c) {
+        if (ready & EPOLLERR) return false;
+        if (!c.closeAfterWrite && (ready & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))) {
+            char chunk[kReadBytes];
+            const ssize_t got = ::recv(fd, chunk, sizeof chunk, 0);
+            if (got == 0) c.closeAfterWrite = true; // peer is done sending; finish what it asked for
+            if (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return false;
+            if (got > 0) {
+                c.in.append(chunk, static_cast<size_t>(got));
+                answerRequests(c);
+            }
+        }
+        while (c.sent < c.out.size()) {
+            const ssize_t put = ::send(fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+            if (put < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return false;
+            }
+            c.sent += static_cast<size_t>(put);
+        }
+        if (c.sent == c.out.size()) {
+            c.out.clear();
+            c.sent = 0;
+            if (c.closeAfterWrite) return false;
+        }
+
+        // Ask for writability only while a response is queued, and stop
+        // reading once the connection is winding down.
+        const uint32_t interest = (c.closeAfterWrite ? 0u : uint32_t{EPOLLIN | EPOLLRDHUP}) |
+                                  (c.out.empty() ? 0u : uint32_t{EPOLLOUT});
+        if (interest != c.interest) {
+            epoll_event ev{};
+            ev.events = interest;
+            ev.data.fd = fd;
+            ::epoll_ctl(ep, EPOLL_CTL_MOD, fd, &ev);
+            c.interest = interest;
+        }
+        return true;
+    }
+
+    // Answers every complete request buffered in `c.in`, appending responses
+    // to `c.out` in order.
+    void answerRequests(Connection& c) const {
+        while (!c.closeAfterWrite) {
+            const size_t end = c.in.find("\r\n\r\n");
+            if (end == std::string::npos) {
+                if (c.in.size() > kMaxHeaderBytes) reject(c, 431, "request header too large");
+                return;
+            }
+            const std::string_view head(c.in.data(), end);
+            const size_t lineEnd = head.find("\r\n");
+            const std::string_view requestLine = head.substr(0, lineEnd);
+            const size_t sp1 = requestLine.find(' ');
+            const size_t sp2 = sp1 == std::string_view::npos ? sp1 : requestLine.find(' ', sp1 + 1);
+            if (sp2 == std::string_view::npos) {
+                reject(c, 400, "malformed request line");
+                return;
+            }
+            const std::string_view method = requestLine.substr(0, sp1);
+            const std::string_view target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+            const std::string_view version = requestLine.substr(sp2 + 1);
+
+            bool keepAlive = version == "HTTP/1.1";
+            bool hasBody = false;
+            std::string_view headers = lineEnd == std::string_view::npos ? std::string_view{} : head.substr(lineEnd + 2);
+            while (!headers.empty()) {
+                const size_t next = headers.find("\r\n");
+                const std::string_view field = headers.substr(0, next);
+                const size_t colon = field.find(':');
+                if (colon != std::string_view::npos) {
+                    std::string name(field.substr(0, colon));
+                    std::string value(trimView(field.substr(colon + 1)));
+                    for (char& ch : name) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+                    for (char& ch : value) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+                    if (name == "connection") keepAlive = value == "keep-alive" || (keepAlive && value != "close");
+                    if ((name == "content-length" && value != "0") || name == "transfer-encoding") hasBody = true;
+                }
+                if (next == std::string_view::npos) break;
+                headers.remove_prefix(next + 2);
+            }
+
+            HttpResponse res;
+            if (hasBody) {
+                reject(c, 400, "request bodies are not accepted"); // cannot find the next request
+                return;
+            }
+            if (method != "GET" && method != "HEAD") {
+                res.status = 405;
+                res.body = "{\"error\":\"only GET and HEAD are supported\"}\n";
+            } else {
+                routeHttp(planner_, target, res);
+            }
+            appendResponse(c, res, method == "HEAD", !keepAlive);
+            c.in.erase(0, end + 4);
+        }
+    }
+
+    static void reject(Connection& c, int status, std::string_view why) {
+        HttpResponse res;
+        res.status = status;
+        res.body.append("{\"error\":");
+        appendJsonString(res.body, why);
+        res.body.append("}\n");
+        appendResponse(c, res, false, true);
+        c.in.clear();
+    }
+
+    static void appendResponse(Connection& c, const HttpResponse& res, bool headOnly, bool close) {
+        c.out.append("HTTP/1.1 ").append(std::to_string(res.status)).append(" ").append(httpReason(res.status));
+        c.out.append("\r\nContent-Type: ").append(res.contentType);
+        c.out.append("\r\nContent-Length: ").append(std::to_string(res.body.size()));
+        c.out.append(close ? "\r\nConnection: close\r\n\r\n" : "\r\n\r\n");
+        if (!headOnly) c.out.append(res.body);
+        if (close) c.closeAfterWrite = true;
+    }
+};
+
+// Serves until SIGINT or SIGTERM. SIGHUP reloads the catalog's source file in
+// place; queries in flight keep the catalog they started with.
+static int runServer(CoursePlanner& planner, uint16_t port, size_t threads, std::ostream& log) {
+    // Block the signals before any worker starts so only sigwait() sees them.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    HttpServer server(planner);
+    std::string err;
+    if (!server.listen(port, err)) {
+        log << err << "\n";
+        return 1;
+    }
+    server.start(threads);
+    log << "Serving on port " << port << " with " << threads << " worker thread(s).\n";
+    log.flush();
+
+    for (;;) {
+        int sig = 0;
+        if (sigwait(&signals, &sig) != 0 || sig != SIGHUP) break;
+        if (!planner.reloadAndReport(planner.lastFilename(), err)) log << err << "\n";
+        log.flush();
+    }
+    log << "Shutting down.\n";
+    log.flush();
+    server.stop();
+    return 0;
+}
+
+#endif // ADVISING_HAVE_EPOLL
+
+// ---------- Benchmarks ----------
+//
+// Built only with -DADVISING_BENCH, which adds `--bench [N,N,...]`:
+//   g++ -std=c++17 -O2 -pthread -DADVISING_BENCH ProjectTwo.cpp -o advising-bench
+//   ./advising-bench --bench 1000,100000
+// For each synthetic catalog shape and row count (default 1k, 10k, 100k, 1M)
+// a CSV is generated in $TMPDIR (or /tmp), then, for each course store,
+// loadFromFile, CourseStore::find, CourseStore::findMany (the same keys in
+// one call), a full inOrder walk and printCourseInfo are timed. Each line reports ns per
+// operation, heap allocations per operation (this build counts calls to the
+// global operator new), and the process's peak RSS so far.
+
+#ifdef ADVISING_BENCH
+
+static std::atomic<uint64_t> gBenchAllocations{0};
+
+// Kept out of line: once either side is inlined, GCC sees malloc() paired with
+// operator delete (or new with free) and warns about a mismatch.
+#if defined(__GNUC__)
+#define ADVISING_NOINLINE __attribute__((noinline))
+#else
+#define ADVISING_NOINLINE
+#endif
+
+ADVISING_NOINLINE void* operator new(size_t bytes) {
+    gBenchAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(bytes ? bytes : 1)) return p;
+    throw std::bad_alloc();
+}
+ADVISING_NOINLINE void operator delete(void* p) noexcept { std::free(p); }
+ADVISING_NOINLINE void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+enum class BenchShape { kRandom, kSorted, kReverse, kChain, kFanOut };
+
+struct BenchShapeInfo {
+    BenchShape shape;
+    const char* name;
+};
+
+static constexpr BenchShapeInfo kBenchShapes[] = {
+    {BenchShape::kRandom, "random"},   // shuffled rows, up to 3 prereqs on earlier courses
+    {BenchShape::kSorted, "sorted"},   // the same rows in key order
+    {BenchShape::kReverse, "reverse"}, // the same rows in descending key order
+    {BenchShape::kChain, "chain"},     // each course requires the one before it
+    {BenchShape::kFanOut, "fanout"},   // every course requires 4 of ~sqrt(n) hub courses
+};
+
+struct BenchStoreInfo {
+    StoreKind kind;
+    const char* name;
+};
+
+static constexpr BenchStoreInfo kBenchStores[] = {{StoreKind::kAvl, "avl"}, {StoreKind::kFlat, "flat"}};
+
+// Distinct fixed-width numbers that sort in index order, e.g. "CSC0001234".
+static std::string benchNumber(size_t i, size_t n) {
+    static constexpr const char* kDepts[] = {"ART", "BIO", "CHE", "CSC", "ECO", "HIS", "MAT", "PHY"};
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%s%07zu", kDepts[i * 8 / n], i);
+    return buf;
+}
+
+static bool writeBenchCatalog(BenchShape shape, size_t n, const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return false;
+
+    std::mt19937_64 rng(n * 31 + static_cast<size_t>(shape));
+    std::vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = i;
+    if (shape == BenchShape::kRandom) std::shuffle(order.begin(), order.end(), rng);
+    if (shape == BenchShape::kReverse) std::reverse(order.begin(), order.end());
+    const size_t hubs = std::max<size_t>(4, static_cast<size_t>(std::sqrt(static_cast<double>(n))));
+
+    std::string buf;
+    for (size_t k : order) {
+        buf.append(benchNumber(k, n)).append(",Synthetic Course ").append(std::to_string(k));
+        if (shape == BenchShape::kChain) {
+            if (k > 0) buf.append(",").append(benchNumber(k - 1, n));
+        } else if (shape == BenchShape::kFanOut) {
+            if (k >= hubs) {
+                for (size_t j = 0; j < 4; ++j) buf.append(",").append(benchNumber((k + j * 7919) % hubs, n));
+            }
+        } else if (k > 0) {
+            // Seeded per row, so random, sorted and reverse describe the same catalog.
+            std::mt19937_64 row(k);
+            for (size_t j = 0, count = row() % 4; j < count; ++j) buf.append(",").append(benchNumber(row() % k, n));
+        }
+        buf.push_back('\n');
+        if (buf.size() >= (1u << 20)) {
+            out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            buf.clear();
+        }
+    }
+    out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    return static_cast<bool>(out.flush());
+}
+
+// Discards everything written to it, so printing costs only the formatting.
+class BenchNullBuf : public std::streambuf {
+protected:
+    int overflow(int ch) override { return ch; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+static size_t benchPeakRssMiB() {
+#ifdef ADVISING_HAVE_MMAP
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss) >> 20; // bytes
+#else
+    return static_cast<size_t>(usage.ru_maxrss) >> 10; // KiB
+#endif
+#else
+    return 0;
+#endif
+}
+
+// Times `reps` calls of `fn` with `opsPerRep` operations each and reports
+// ns and allocations per operation.
+template <typename Fn>
+static void benchMeasure(size_t reps, size_t opsPerRep, Fn&& fn, double& nsPerOp, double& allocsPerOp) {
+    const uint64_t allocs = gBenchAllocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < reps; ++r) fn();
+    const auto stop = std::chrono::steady_clock::now();
+    const double ops = static_cast<double>(reps) * static_cast<double>(opsPerRep);
+    nsPerOp = std::chrono::duration<double, std::nano>(stop - start).count() / ops;
+    allocsPerOp = static_cast<double>(gBenchAllocations.load(std::memory_order_relaxed) - allocs) / ops;
+}
+
+static int runBenchmarks(const std::vector<size_t>& sizes) {
+    constexpr size_t kLookups = 200000;
+    const char* tmp = std::getenv("TMPDIR");
+    const std::string dir = tmp && *tmp ? tmp : "/tmp";
+
+    BenchNullBuf nullBuf;
+    std::ostream null(&nullBuf);
+    std::cout << std::left << std::setw(8) << "shape" << std::setw(6) << "store" << std::right << std::setw(9)
+              << "rows" << std::setw(14) << "load ns/row" << std::setw(12) << "allocs/row" << std::setw(10)
+              << "find ns" << std::setw(13) << "findMany ns" << std::setw(16) << "inOrder ns/row" << std::setw(10) << "info ns" << std::setw(13)
+              << "allocs/info" << std::setw(14) << "peak RSS MiB" << "\n";
+
+    for (const BenchShapeInfo& s : kBenchShapes) {
+        for (size_t n : sizes) {
+            const std::string path = dir + "/advising-bench-" + s.name + "-" + std::to_string(n) + ".csv";
+            if (!writeBenchCatalog(s.shape, n, path)) {
+                std::cerr << "Error: Could not write \"" << path << "\".\n";
+                return 1;
+            }
+
+            for (const BenchStoreInfo& store : kBenchStores) {
+                // The planner (and each catalog it loaded) is gone before the next run.
+                CoursePlanner planner;
+                planner.setLog(null);
+                planner.setStoreKind(store.kind);
+                std::string err;
+                double loadNs = 0, loadAllocs = 0;
+                bool ok = true;
+                benchMeasure(std::max<size_t>(1, 100000 / n), n, [&] { ok = ok && planner.loadFromFile(path, err); },
+                             loadNs, loadAllocs);
+                if (!ok) {
+                    std::cerr << err << "\n";
+                    std::remove(path.c_str());
+                    return 1;
+                }
+
+                std::mt19937_64 rng(n);
+                std::vector<std::string> keys(kLookups);
+                for (std::string& k : keys) k = benchNumber(rng() % n, n);
+                std::vector<std::string_view> views(keys.begin(), keys.end());
+                std::vector<const Course*> found(kLookups);
+
+                std::shared_ptr<const Catalog> cat = planner.catalog();
+                size_t checksum = 0;
+                double findNs = 0, findManyNs = 0, walkNs = 0, infoNs = 0, infoAllocs = 0, unused = 0;
+                benchMeasure(1, kLookups, [&] {
+                    for (const std::string& k : keys) checksum += cat->store->find(k) != nullptr;
+                }, findNs, unused);
+                benchMeasure(1, kLookups, [&] {
+                    cat->store->findMany({views.data(), views.size()}, found.data());
+                    for (const Course* c : found) checksum += c != nullptr;
+                }, findManyNs, unused);
+                benchMeasure(std::max<size_t>(1, 1000000 / n), n, [&] {
+                    cat->store->inOrder([&](const Course& c) { checksum += c.prereqs.size(); });
+                }, walkNs, unused);
+                benchMeasure(1, kLookups, [&] {
+                    for (const std::string& k : keys) planner.printCourseInfo(k, null);
+                }, infoNs, infoAllocs);
+                if (checksum == 0) std::cerr << "(no lookups hit)\n"; // keeps the loops observable
+
+                std::cout << std::left << std::setw(8) << s.name << std::setw(6) << store.name << std::right
+                          << std::setw(9) << n << std::fixed << std::setprecision(1) << std::setw(14) << loadNs
+                          << std::setw(12) << loadAllocs
+                          << std::setw(10) << findNs << std::setw(13) << findManyNs << std::setw(16) << walkNs << std::setw(10) << infoNs
+                          << std::setw(13) << infoAllocs << std::setw(14) << benchPeakRssMiB() << "\n";
+                std::cout.flush();
+            }
+            std::remove(path.c_str());
+        }
+    }
+    return 0;
+}
+
+#endif // ADVISING_BENCH
+
+static int usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [OPTIONS] [courses.csv]\n"
+              << "       " << argv0 << " --batch [--json] [--queries FILE] [OPTIONS] [courses.csv]\n"
+              << "       " << argv0 << " --serve PORT [--threads N] [OPTIONS] [courses.csv]\n"
+              << "       " << argv0 << " --paged FILE [--pool-pages N] [--json] [--queries FILE] [courses.csv]\n"
+              << "Options: --snapshot FILE  --cache-entries N  --store avl|flat  --term NAME=FILE\n";
+#ifdef ADVISING_BENCH
+    std::cerr << "       " << argv0 << " --bench [N,N,...]\n";
+#endif
+    return 2;
+}
+
+int main(int argc, char* argv[]) {
+    std::ios::sync_with_stdio(false);
+
+    CoursePlanner planner;
+
+    std::string snapshotPath;
+    std::string csvPath;
+    std::string queriesPath;
+    std::string pagedPath;
+    std::vector<std::pair<std::string, std::string>> terms; // --term NAME=FILE, in order
+    unsigned long poolPages = 0;  // --pool-pages; 0 keeps the default
+    bool batch = false;
+    bool json = false;
+    unsigned long port = 0;     // --serve, when nonzero
+    unsigned long threads = 0;  // server workers; 0 picks one per core
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--snapshot" && i + 1 < argc) {
+            snapshotPath = argv[++i];
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg == "--json") {
+            json = true;
+        } else if (arg == "--queries" && i + 1 < argc) {
+            queriesPath = argv[++i];
+        } else if (arg == "--term" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t eq = spec.find('=');
+            if (eq == 0 || eq == std::string::npos || eq + 1 == spec.size()) return usage(argv[0]);
+            terms.emplace_back(spec.substr(0, eq), spec.substr(eq + 1));
+        } else if (arg == "--paged" && i + 1 < argc) {
+            pagedPath = argv[++i];
+        } else if (arg == "--pool-pages" && i + 1 < argc) {
+            char* end = nullptr;
+            poolPages = std::strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || poolPages == 0) return usage(argv[0]);
+#ifdef ADVISING_BENCH
+        } else if (arg == "--bench") {
+            std::vector<size_t> sizes;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                for (const std::string& n : splitCourseList(argv[++i])) {
+                    char* end = nullptr;
+                    unsigned long rows = std::strtoul(n.c_str(), &end, 10);
+                    if (*end != '\0' || rows == 0) return usage(argv[0]);
+                    sizes.push_back(rows);
+                }
+            } else {
+                sizes = {1000, 10000, 100000, 1000000};
+            }
+            return runBenchmarks(sizes);
+#endif
+        } else if (arg == "--store" && i + 1 < argc) {
+            StoreKind kind;
+            if (!parseStoreKind(argv[++i], kind)) return usage(argv[0]);
+            planner.setStoreKind(kind);
+        } else if (arg == "--cache-entries" && i + 1 < argc) {
+            char* end = nullptr;
+            unsigned long value = std::strtoul(argv[++i], &end, 10);
+            if (*end != '\0') return usage(argv[0]);
+            planner.setResponseCacheCapacity(value);
+        } else if ((arg == "--serve" || arg == "--threads") && i + 1 < argc) {
+            char* end = nullptr;
+            unsigned long value = std::strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || value == 0 || value > (arg == "--serve" ? 65535ul : 1024ul)) return usage(argv[0]);
+            (arg == "--serve" ? port : threads) = value;
+        } else if (!arg.empty() && arg[0] != '-' && csvPath.empty()) {
+            csvPath = arg;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (!pagedPath.empty()) {
+        // The paged catalog never loads into the planner, so the options that
+        // shape or serve an in-memory catalog do not apply.
+        if (port || !snapshotPath.empty() || !terms.empty()) return usage(argv[0]);
+        return runPaged(pagedPath, csvPath, poolPages ? poolPages : 256, queriesPath, json);
+    }
+    if (poolPages) return usage(argv[0]);
+    if ((!queriesPath.empty() || json) && !batch) return usage(argv[0]);
+    if ((threads && !port) || (port && batch)) return usage(argv[0]);
+    if (!terms.empty() && (!snapshotPath.empty() || !csvPath.empty())) return usage(argv[0]);
+
+    // In batch mode stdout carries only answers; load progress goes to stderr.
+    std::ostream& log = batch ? std::cerr : std::cout;
+    planner.setLog(log);
+    if (!snapshotPath.empty()) {
+        loadAtStartup(planner, snapshotPath, csvPath, log);
+    } else if (!csvPath.empty()) {
+        std::string err;
+        if (!planner.loadFromFile(csvPath, err)) log << err << "\n";
+        log << "\n";
+    } else if (!terms.empty()) {
+        std::string err;
+        for (const auto& [name, file] : terms) {
+            if (!planner.loadTerm(name, file, err)) log << err << "\n";
+        }
+        log << "\n";
+    }
+
+    if (batch) {
+        if (!planner.isLoaded()) {
+            std::cerr << "Batch mode needs a course data file or snapshot.\n";
+            return 1;
+        }
+        // Queries never wait on answers, so don't flush stdout before each read.
+        std::cin.tie(nullptr);
+        PlannerQueries backend(planner);
+        if (queriesPath.empty()) {
+            runBatch(backend, std::cin, std::cout, json);
+        } else {
+            std::ifstream queries(queriesPath);
+            if (!queries.is_open()) {
+                std::cerr << "Error: Could not open file \"" << queriesPath << "\".\n";
+                return 1;
+            }
+            runBatch(backend, queries, std::cout, json);
+        }
+        return 0;
+    }
+    if (port) {
+        if (!planner.isLoaded()) {
+            std::cerr << "Server mode needs a course data file or snapshot.\n";
+            return 1;
+        }
+#ifdef ADVISING_HAVE_EPOLL
+        if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+        return runServer(planner, static_cast<uint16_t>(port), threads, std::cout);
+#else
+        std::cerr << "Server mode is only available on Linux.\n";
+        return 1;
+#endif
+    }
+    planner.setLog(std::cout);
+
+    // At a terminal, option 1 loads in the background (see BackgroundLoad).
+    // Options that would wait on that load are refused until it ends.
+    const bool interactive = interactiveInput();
+    BackgroundLoad load;
+    auto busy = [&] {
+        if (!load.running()) return false;
+        std::cout << "A load is already in progress; wait for it to finish or cancel it with option 15.\n\n";
+        return true;
+    };
+
+    while (true) {
+        load.report(std::cout);
+        printMenu();
+
+        std::string choiceLine;
+        if (!std::getline(std::cin, choiceLine)) {
+            std::cout << "\nInput stream closed. Exiting.\n";
+            load.cancel();
+            load.finish(std::cout);
+            break;
+        }
+        std::string choice = trimCopy(choiceLine);
+
+        if (choice.empty() && load.running()) {
+            continue; // just show the progress again
+
+        } else if (choice == "1") {
+            if (busy()) continue;
+            std::cout << "Enter the course data filename (e.g., courses.csv): ";
+            std::string fname;
+            std::getline(std::cin, fname);
+            fname = trimCopy(fname);
+
+            if (fname.empty()) {
+                std::cout << "Error: filename cannot be empty.\n\n";
+                continue;
+            }
+
+            if (interactive && load.start(planner, fname)) {
+                std::cout << "Loading \"" << fname << "\" in the background; "
+                          << "queries use the current catalog until it is ready.\n\n";
+                continue;
+            }
+            std::string err;
+            if (!planner.loadFromFile(fname, err)) {
+                std::cout << err << "\n\n";
+            } else {
+                std::cout << "File \"" << planner.lastFilename() << "\" loaded successfully.\n\n";
+            }
+
+        } else if (choice == "2") {
+            planner.printCourseList(std::cout);
+
+        } else if (choice == "3") {
+            std::cout << "Enter a course number to look up (e.g., CSCI200): ";
+            std::string num;
+            std::getline(std::cin, num);
+            planner.printCourseInfo(num, std::cout);
+
+        } else if (choice == "4") {
+            std::cout << "Enter the snapshot filename (e.g., catalog.snap): ";
+            std::string fname;
+            std::getline(std::cin, fname);
+            fname = trimCopy(fname);
+
+            if (fname.empty()) {
+                std::cout << "Error: filename cannot be empty.\n\n";
+                continue;
+            }
+
+            std::string err;
+            if (!planner.saveSnapshot(fname, err)) {
+                std::cout << err << "\n\n";
+            } else {
+                std::cout << "Snapshot \"" << fname << "\" saved.\n\n";
+            }
+
+        } else if (choice == "5") {
+            if (busy()) continue;
+            std::cout << "Enter the course data filename (blank reloads the current file): ";
+            std::string fname;
+            std::getline(std::cin, fname);
+            fname = trimCopy(fname);
+            if (fname.empty()) fname = planner.lastFilename();
+
+            if (fname.empty()) {
+                std::cout << "Error: filename cannot be empty.\n\n";
+                continue;
+            }
+
+            std::string err;
+            if (!planner.reloadAndReport(fname, err)) {
+                std::cout << err << "\n\n";
+            } else {
+                std::cout << "\n";
+            }
+
+        } else if (choice == "6") {
+            std::cout << "Enter a course number to look up (e.g., CSCI300): ";
+            std::string num;
+            std::getline(std::cin, num);
+            planner.printPrereqChain(num, std::cout);
+
+        } else if (choice == "7") {
+            std::string targets, completed, cap;
+            std::cout << "Enter target course numbers (e.g., CSCI400 MATH201): ";
+            std::getline(std::cin, targets);
+            std::cout << "Enter completed course numbers (blank for none): ";
+            std::getline(std::cin, completed);
+            std::cout << "Enter the maximum courses per term (e.g., 3): ";
+            std::getline(std::cin, cap);
+
+            size_t maxPerTerm = 0;
+            try {
+                maxPerTerm = static_cast<size_t>(std::stoul(trimCopy(cap)));
+            } catch (const std::exception&) {
+            }
+            if (maxPerTerm == 0) {
+                std::cout << "Error: the maximum must be a positive number.\n\n";
+                continue;
+            }
+            planner.printTermPlan(splitCourseList(targets), splitCourseList(completed), maxPerTerm, std::cout);
+
+        } else if (choice == "8") {
+            std::cout << "Enter a prefix (e.g., CSCI3) or a range (e.g., MATH100 MATH299): ";
+            std::string line;
+            std::getline(std::cin, line);
+            std::vector<std::string> bounds = splitCourseList(line);
+            if (bounds.empty() || bounds.size() > 2) {
+                std::cout << "Error: enter one prefix or two course numbers.\n\n";
+                continue;
+            }
+            planner.printCourseRange(bounds[0], bounds.size() == 2 ? bounds[1] : std::string(), std::cout);
+
+        } else if (choice == "10") {
+            std::cout << "Enter title words (e.g., data struct*): ";
+            std::string query;
+            std::getline(std::cin, query);
+            planner.printTitleSearch(query, std::cout);
+
+        } else if (choice == "11") {
+            planner.writeStats(std::cout);
+            std::cout << "\n";
+
+        } else if (choice == "12") {
+            if (busy()) continue;
+            std::string name, fname;
+            std::cout << "Enter a name for the term (e.g., fall2024): ";
+            std::getline(std::cin, name);
+            std::cout << "Enter the course data filename (e.g., courses.csv): ";
+            std::getline(std::cin, fname);
+            name = trimCopy(name);
+            fname = trimCopy(fname);
+
+            if (fname.empty()) {
+                std::cout << "Error: filename cannot be empty.\n\n";
+                continue;
+            }
+
+            std::string err;
+            if (!planner.loadTerm(name, fname, err)) {
+                std::cout << err << "\n\n";
+            } else {
+                std::cout << "Term \"" << name << "\" loaded and selected.\n\n";
+            }
+
+        } else if (choice == "13") {
+            if (busy()) continue;
+            planner.printTerms(std::cout);
+            std::cout << "Enter the term to switch to: ";
+            std::string name;
+            std::getline(std::cin, name);
+
+            std::string err;
+            if (!planner.useTerm(trimCopy(name), err)) {
+                std::cout << err << "\n\n";
+            } else {
+                std::cout << "Now using term \"" << trimCopy(name) << "\".\n\n";
+            }
+
+        } else if (choice == "14") {
+            std::string from, to;
+            std::cout << "Enter the earlier term (e.g., fall2024): ";
+            std::getline(std::cin, from);
+            std::cout << "Enter the later term (e.g., spring2025): ";
+            std::getline(std::cin, to);
+            planner.printTermDiff(trimCopy(from), trimCopy(to), std::cout);
+
+        } else if (choice == "15") {
+            if (!load.running()) {
+                std::cout << "No load is in progress.\n\n";
+                continue;
+            }
+            load.cancel();
+            load.finish(std::cout);
+
+        } else if (choice == "16") {
+            std::cout << "Enter a course number to look up (e.g., MATH201): ";
             std::string num;
             std::getline(std::cin, num);
-            planner.printCourseInfo(num);
+            planner.printDependents(num, std::cout);
 
         } else if (choice == "9") {
+            load.cancel();
+            load.finish(std::cout);
             std::cout << "Goodbye!\n";
             break;
 
         } else {
-            std::cout << "Invalid selection. Please enter 1, 2, 3, or 9.\n\n";
+            std::cout << "Invalid selection. Please enter a number from 1 to 16.\n\n";
         }
     }
 